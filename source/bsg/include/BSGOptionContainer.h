@@ -63,6 +63,10 @@ class BSGOptionContainer {
   inline static void ClearVariablesMap() {
      vm.clear();
    };
+  /**
+   * Get a copy of all options, e.g. to construct a GeneratorConfig
+   */
+  inline static po::variables_map GetVariablesMap() { return vm; };
   /**
    * Check whether an options was given
    *
@@ -5,11 +5,17 @@
 #include "gsl/gsl_sf_laguerre.h"
 #include "gsl/gsl_sf_gamma.h"
 
+#include <algorithm>
+#include <cmath>
 #include <complex>
+#include <stdexcept>
+#include <string>
 
+#ifdef BSG_USE_ROOT
 #include "TMath.h"
 #include "TF1.h"
 #include "TGraph.h"
+#endif
 
 namespace bsg {
 /**
@@ -290,6 +296,7 @@ inline double ChargeMG(double r, double A, double R) {
          (1. + A * std::pow(r / a, 2.)) * exp(-std::pow(r / a, 2.)) * r * r;
 }
 
+#ifdef BSG_USE_ROOT
 /**
  * Wrapper function around the Harmonic Oscillator charge density functions used by the ROOT fitter
  *
@@ -319,6 +326,7 @@ inline Double_t ChargeMG_f(Double_t x[], Double_t par[]) {
 
   return f;
 }
+#endif
 
 /**
  * Calculate the angle-averaged charge density distribution for a quadrupole deformed nucleus
@@ -359,6 +367,128 @@ inline double GetDerivDeformedChargeDist(double r, double a, double b) {
   return result;
 }
 
+/**
+ * Points of the Harmonic Oscillator charge distribution to which the Modified
+ * Gaussian distribution is fitted
+ */
+struct HOFitData {
+  std::vector<double> r; /**< the radii */
+  std::vector<double> rho; /**< the normalised Harmonic Oscillator charge density */
+  double R; /**< the radius of the Modified Gaussian distribution */
+};
+
+/**
+ * Residuals of the Modified Gaussian fit in the form required by GSL
+ */
+inline int HOFitResiduals(const gsl_vector* x, void* params, gsl_vector* f) {
+  HOFitData* data = static_cast<HOFitData*>(params);
+  double A = gsl_vector_get(x, 0);
+  for (std::size_t i = 0; i < data->r.size(); i++) {
+    gsl_vector_set(f, i, ChargeMG(data->r[i], A, data->R) - data->rho[i]);
+  }
+  return GSL_SUCCESS;
+}
+
+/**
+ * Jacobian of the residuals of the Modified Gaussian fit, using central
+ * differences
+ */
+inline int HOFitJacobian(const gsl_vector* x, void* params, gsl_matrix* J) {
+  HOFitData* data = static_cast<HOFitData*>(params);
+  double A = gsl_vector_get(x, 0);
+  double h = 1e-7 * std::max(1., std::abs(A));
+  for (std::size_t i = 0; i < data->r.size(); i++) {
+    gsl_matrix_set(J, i, 0, (ChargeMG(data->r[i], A + h, data->R) - ChargeMG(data->r[i], A - h, data->R)) / (2. * h));
+  }
+  return GSL_SUCCESS;
+}
+
+inline int HOFitResidualsAndJacobian(const gsl_vector* x, void* params, gsl_vector* f, gsl_matrix* J) {
+  HOFitResiduals(x, params, f);
+  return HOFitJacobian(x, params, J);
+}
+
+/**
+ * Fit the charge distribution as constructed using Harmonic Oscillator functions
+ * to a Modified Gaussian distribution using the Levenberg-Marquardt solver of
+ * GSL. The fit is the same unweighted least squares fit to 50 points as
+ * performed by ROOT in FitHODist.
+ *
+ * @param Z the proton number of the nucleus
+ * @param rms the nuclear RMS radius
+ * @returns the fitted A parameter of the Modified Gaussian density
+ * @throws std::runtime_error if the fit does not converge within 500 iterations
+ * or the solver stops away from a minimum
+ * @see FitHODist
+ */
+inline double FitHODistGSL(int Z, double rms) {
+  const std::size_t n = 50;
+  HOFitData data;
+  data.R = std::sqrt(5. / 3.) * rms;
+  for (std::size_t i = 0; i < n; i++) {
+    data.r.push_back(i * 5 * rms / n);
+    data.rho.push_back(ChargeHO(data.r[i], rms, Z, true));
+  }
+
+  gsl_multifit_function_fdf f;
+  f.f = &HOFitResiduals;
+  f.df = &HOFitJacobian;
+  f.fdf = &HOFitResidualsAndJacobian;
+  f.n = n;
+  f.p = 1;
+  f.params = &data;
+
+  gsl_vector* x = gsl_vector_alloc(1);
+  gsl_vector_set(x, 0, 5.0);
+  gsl_multifit_fdfsolver* s = gsl_multifit_fdfsolver_alloc(gsl_multifit_fdfsolver_lmsder, n, 1);
+  gsl_multifit_fdfsolver_set(s, &f, x);
+
+  int status, iter = 0;
+  do {
+    iter++;
+    status = gsl_multifit_fdfsolver_iterate(s);
+    if (status) break;
+    status = gsl_multifit_test_delta(s->dx, s->x, 1e-12, 1e-12);
+  } while (status == GSL_CONTINUE && iter < 500);
+
+  double A = gsl_vector_get(gsl_multifit_fdfsolver_position(s), 0);
+
+  gsl_multifit_fdfsolver_free(s);
+  gsl_vector_free(x);
+  // lmsder reports no progress once the step can no longer lower the sum of
+  // squares, which is fine if the residuals are orthogonal to the Jacobian
+  if (status == GSL_ENOPROG && std::isfinite(A)) {
+    double h = 1e-7 * std::max(1., std::abs(A));
+    double grad = 0., fNorm = 0., jNorm = 0.;
+    for (std::size_t i = 0; i < n; i++) {
+      double res = ChargeMG(data.r[i], A, data.R) - data.rho[i];
+      double jac = (ChargeMG(data.r[i], A + h, data.R) - ChargeMG(data.r[i], A - h, data.R)) / (2. * h);
+      grad += res * jac;
+      fNorm += res * res;
+      jNorm += jac * jac;
+    }
+    if (std::abs(grad) <= 1e-6 * std::sqrt(fNorm * jNorm)) status = GSL_SUCCESS;
+  }
+  // an unconverged fit would be stored in the fit cache, so it is an error
+  if (status != GSL_SUCCESS || !std::isfinite(A)) {
+    throw std::runtime_error("Modified Gaussian fit for Z = " + std::to_string(Z) + " did not converge after " +
+                             std::to_string(iter) + " iterations: " +
+                             (status == GSL_CONTINUE ? "iteration limit reached" : gsl_strerror(status)));
+  }
+  return A;
+}
+
+/**
+ * Enum to distinguish the fitters of FitHODist, whose results differ slightly
+ */
+enum HOFitter { HO_FIT_ROOT = 1, HO_FIT_GSL = 2 };
+
+#ifdef BSG_USE_ROOT
+/**
+ * The fitter used by FitHODist
+ */
+const HOFitter hoFitter = HO_FIT_ROOT;
+
 /**
  * Fit the charge distribution as constructed using Harmonic Oscillator functions
  * to a Modified Gaussian distribution using ROOT.
@@ -400,6 +530,23 @@ inline double FitHODist(int Z, double rms) {
   //delete histHO;
   return A;
 }
+#else
+/**
+ * The fitter used by FitHODist
+ */
+const HOFitter hoFitter = HO_FIT_GSL;
+
+/**
+ * Fit the charge distribution as constructed using Harmonic Oscillator functions
+ * to a Modified Gaussian distribution. Without ROOT the fit is performed by GSL.
+ *
+ * @param Z the proton number of the nucleus
+ * @param rms the nuclear RMS radius
+ * @returns the fitted A parameter of the Modified Gaussian density
+ * @see FitHODistGSL
+ */
+inline double FitHODist(int Z, double rms) { return FitHODistGSL(Z, rms); }
+#endif
 }
 }
 #endif
@@ -0,0 +1,231 @@
+#ifndef CORRECTIONPLAN
+#define CORRECTIONPLAN
+
+#include "BSGConfig.h"
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+namespace bsg {
+
+class CorrectionProfile;
+
+/**
+ * Enum identifying the spectral corrections, listed in the order in which they
+ * are applied to the spectrum
+ */
+enum CorrectionType {
+  PHASE_SPACE,
+  FERMI_FUNCTION,
+  C_CORRECTION,
+  RELATIVISTIC_CORRECTION,
+  DEFORMATION_CORRECTION,
+  L0_CORRECTION,
+  U_CORRECTION,
+  Q_CORRECTION,
+  RADIATIVE_CORRECTION,
+  RECOIL_CORRECTION,
+  ATOMIC_SCREENING,
+  ATOMIC_EXCHANGE,
+  ATOMIC_MISMATCH
+};
+
+/**
+ * Function filling n contiguous correction values for n contiguous energies
+ */
+typedef std::function<void(const double*, double*, std::size_t)> BatchFunction;
+
+/**
+ * A single enabled correction with all of its transition constants bound.
+ * The electron part is evaluated at W, the neutrino part at W0 - W + 1.
+ * The batch functions are optional and are used when evaluating a block of
+ * energies.
+ */
+struct Correction {
+  CorrectionType type;
+  bool shared; /**< depends on the energy only through W, so that the neutrino part at Wv is the electron part at the mirrored point */
+  std::function<double(double)> electron;
+  std::function<double(double)> neutrino;
+  BatchFunction electronBatch;
+  BatchFunction neutrinoBatch;
+};
+
+/**
+ * Flat list of the enabled spectral corrections of a transition.
+ * The plan is resolved once from the spectrum options so that evaluating a
+ * decay rate requires no option lookups or string comparisons.
+ */
+class CorrectionPlan {
+ public:
+  /**
+   * Constructor
+   *
+   * @param W0 the total endpoint energy in units of the electron rest mass
+   */
+  CorrectionPlan(double W0 = 1.) : W0(W0) {};
+
+  /**
+   * Add a correction which has the same functional form for the electron
+   * and the neutrino
+   *
+   * @param type the CorrectionType of the correction
+   * @param f the correction as a function of the total energy
+   */
+  void Add(CorrectionType type, std::function<double(double)> f);
+  /**
+   * Add a correction which has the same functional form for the electron
+   * and the neutrino, together with its batch version
+   *
+   * @param type the CorrectionType of the correction
+   * @param f the correction as a function of the total energy
+   * @param fBatch the correction evaluated for an array of total energies
+   */
+  void Add(CorrectionType type, std::function<double(double)> f,
+           BatchFunction fBatch);
+  /**
+   * Add a correction with a different functional form for the electron
+   * and the neutrino
+   *
+   * @param type the CorrectionType of the correction
+   * @param electron the electron correction as a function of W
+   * @param neutrino the neutrino correction as a function of Wv
+   */
+  void Add(CorrectionType type, std::function<double(double)> electron,
+           std::function<double(double)> neutrino);
+
+  /**
+   * Replace a correction which has the same functional form for the electron
+   * and the neutrino, keeping its place in the plan
+   *
+   * @param type the CorrectionType of the correction
+   * @param f the correction as a function of the total energy
+   * @param fBatch the correction evaluated for an array of total energies
+   * @returns false if the correction is not part of the plan
+   */
+  bool Replace(CorrectionType type, std::function<double(double)> f,
+               BatchFunction fBatch);
+  /**
+   * Replace a correction which has the same functional form for the electron
+   * and the neutrino, keeping its place in the plan
+   *
+   * @param type the CorrectionType of the correction
+   * @param f the correction as a function of the total energy
+   * @returns false if the correction is not part of the plan
+   */
+  bool Replace(CorrectionType type, std::function<double(double)> f);
+  /**
+   * Replace a correction with a different functional form for the electron
+   * and the neutrino, keeping its place in the plan
+   *
+   * @param type the CorrectionType of the correction
+   * @param electron the electron correction as a function of W
+   * @param neutrino the neutrino correction as a function of Wv
+   * @returns false if the correction is not part of the plan
+   */
+  bool Replace(CorrectionType type, std::function<double(double)> electron,
+               std::function<double(double)> neutrino);
+
+  /**
+   * Check whether a correction is part of the plan
+   *
+   * @param type the CorrectionType of the correction
+   */
+  bool IsEnabled(CorrectionType type) const;
+
+  /**
+   * Evaluate the product of all corrections
+   *
+   * @param W the total electron energy in units of its rest mass
+   * @returns the electron and neutrino decay rates at energy W
+   */
+  std::tuple<double, double> Evaluate(double W) const;
+  /**
+   * Evaluate the product of all corrections for a block of energies.
+   * Corrections are applied one at a time over the whole block, using their
+   * batch version when available. Safe to call concurrently.
+   *
+   * @param W array of n total electron energies in units of its rest mass
+   * @param electron array of n electron decay rates to be filled
+   * @param neutrino array of n neutrino decay rates to be filled
+   * @param n number of energies
+   */
+  void Evaluate(const double* W, double* electron, double* neutrino,
+                std::size_t n) const;
+  /**
+   * Evaluate the product of all corrections on a grid of energies.
+   * The shared corrections are evaluated only once on the union of the
+   * electron energies and the neutrino energies W0 - W + 1, where points
+   * closer than a relative 1e-12 are merged. A grid which is symmetric
+   * about (W0 + 1)/2 is detected, and the neutrino energy of every point is
+   * taken to be the electron energy of its mirror image, which halves their
+   * cost without sorting. On any other uniform grid whose neutrino energies
+   * fall between its points, such as the default grid, nothing can be merged
+   * and the sorting is skipped as well. Blocks of energies are distributed
+   * over a number of threads.
+   *
+   * @param W the grid of total electron energies in units of its rest mass
+   * @param electron vector to be filled with the electron decay rates
+   * @param neutrino vector to be filled with the neutrino decay rates
+   * @param nThreads number of threads
+   * @returns the number of energies which were merged
+   */
+  std::size_t Evaluate(const std::vector<double>& W,
+                       std::vector<double>& electron,
+                       std::vector<double>& neutrino, int nThreads) const;
+
+  inline const std::vector<Correction>& GetCorrections() const { return corrections; };
+  inline double GetEndpoint() const { return W0; };
+  /**
+   * Set the endpoint used to calculate the neutrino energies
+   *
+   * @param endpoint the total endpoint energy in units of the electron rest mass
+   */
+  inline void SetEndpoint(double endpoint) { W0 = endpoint; };
+
+  static constexpr std::size_t blockSize = 64; /**< number of energies evaluated one correction at a time */
+
+#ifdef BSG_PROFILE_CORRECTIONS
+  /**
+   * Record the time spent in every correction into a profile
+   *
+   * @param p the profile, or nullptr to stop recording
+   */
+  inline void SetProfile(CorrectionProfile* p) { profile = p; };
+#endif
+
+  /**
+   * Check whether a correction depends on the energy only through W and can
+   * be shared between the electron and the neutrino
+   *
+   * @param type the CorrectionType of the correction
+   */
+  static bool DependsOnlyOnW(CorrectionType type);
+  /**
+   * Get the name of a correction, i.e. the name of the Spectrum option
+   * turning it on
+   *
+   * @param type the CorrectionType of the correction
+   */
+  static std::string GetName(CorrectionType type);
+
+ private:
+  /**
+   * Multiply result with either the shared or the other corrections for a
+   * block of at most blockSize energies, using factor as scratch space
+   */
+  void Apply(const double* W, double* result, double* factor, std::size_t n,
+             bool neutrinoSide, bool shared) const;
+
+  double W0; /**< the total endpoint energy in units of the electron rest mass */
+  std::vector<Correction> corrections; /**< enabled corrections in order of application */
+#ifdef BSG_PROFILE_CORRECTIONS
+  CorrectionProfile* profile = nullptr; /**< profile recording the time spent per correction */
+#endif
+};
+
+}
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef CORRECTIONPROFILE
+#define CORRECTIONPROFILE
+
+#include "BSGConfig.h"
+#include "CorrectionPlan.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+/**
+ * Hooks timing the corrections of a CorrectionPlan. They are only compiled in
+ * when configuring with BSG_PROFILE_CORRECTIONS, which BSGConfig.h defines,
+ * and expand to nothing otherwise.
+ */
+#ifdef BSG_PROFILE_CORRECTIONS
+#define BSG_PROFILE_START(start) const std::uint64_t start = bsg::ReadCycleCounter()
+#define BSG_PROFILE_STOP(profile, type, start, points)                    \
+  do {                                                                    \
+    if (profile)                                                          \
+      (profile)->Record(type, bsg::ReadCycleCounter() - (start), points); \
+  } while (0)
+#else
+#define BSG_PROFILE_START(start) \
+  do {                           \
+  } while (0)
+#define BSG_PROFILE_STOP(profile, type, start, points) \
+  do {                                                 \
+  } while (0)
+#endif
+
+namespace bsg {
+
+/**
+ * Read the time stamp counter, or a nanosecond clock where there is none
+ */
+inline std::uint64_t ReadCycleCounter() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/**
+ * Accumulated timing of a single correction. Every call is the evaluation of
+ * the correction at one energy or, for the batch kernels, at a block of
+ * energies.
+ */
+struct CorrectionTiming {
+  std::atomic<std::uint64_t> calls{0}; /**< number of calls */
+  std::atomic<std::uint64_t> points{0}; /**< number of energies evaluated */
+  std::atomic<std::uint64_t> cycles{0}; /**< cumulative duration in counter ticks */
+  std::atomic<std::uint64_t> minCycles{UINT64_MAX}; /**< duration of the fastest call */
+  std::atomic<std::uint64_t> maxCycles{0}; /**< duration of the slowest call */
+};
+
+/**
+ * Per-correction time, call counts and minimal and maximal latency of the
+ * evaluation of a CorrectionPlan, which may be recorded from many threads at
+ * once. Durations are measured in ticks of ReadCycleCounter and converted to
+ * ns using the ticks and time elapsed since the last Reset.
+ */
+class CorrectionProfile {
+ public:
+  CorrectionProfile() { Reset(); };
+  CorrectionProfile(const CorrectionProfile&) = delete;
+  CorrectionProfile& operator=(const CorrectionProfile&) = delete;
+
+  /**
+   * Record a single call of a correction
+   *
+   * @param type the CorrectionType of the correction
+   * @param cycles the duration of the call in counter ticks
+   * @param points the number of energies evaluated
+   */
+  inline void Record(CorrectionType type, std::uint64_t cycles, std::size_t points) {
+    CorrectionTiming& t = timings[type];
+    t.calls.fetch_add(1, std::memory_order_relaxed);
+    t.points.fetch_add(points, std::memory_order_relaxed);
+    t.cycles.fetch_add(cycles, std::memory_order_relaxed);
+    std::uint64_t current = t.minCycles.load(std::memory_order_relaxed);
+    while (cycles < current && !t.minCycles.compare_exchange_weak(current, cycles, std::memory_order_relaxed)) {
+    }
+    current = t.maxCycles.load(std::memory_order_relaxed);
+    while (cycles > current && !t.maxCycles.compare_exchange_weak(current, cycles, std::memory_order_relaxed)) {
+    }
+  }
+
+  /**
+   * Clear all timings and restart the calibration of the counter
+   */
+  void Reset();
+
+  /**
+   * Format the timings as a table with one row per correction which was called
+   */
+  std::string FormatTable() const;
+  /**
+   * Format the timings as a JSON object
+   */
+  std::string FormatJson() const;
+
+  static const int nCorrectionTypes = ATOMIC_MISMATCH + 1;
+
+ private:
+  /**
+   * Number of ns per counter tick, measured since the last Reset
+   */
+  double GetNsPerCycle() const;
+
+  CorrectionTiming timings[nCorrectionTypes];
+  std::uint64_t startCycles; /**< counter value at the last Reset */
+  std::chrono::steady_clock::time_point startTime; /**< time of the last Reset */
+};
+
+}
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef FITCACHE
+#define FITCACHE
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace bsg {
+
+/**
+ * Entry of the fit cache file
+ */
+struct FitCacheEntry {
+  std::uint64_t key; /**< hash of the fitter, Z and the bits of the RMS radius, 0 for an empty entry */
+  std::int32_t fitter; /**< the ChargeDistributions::HOFitter which performed the fit */
+  std::int32_t Z; /**< the proton number */
+  double rms; /**< the RMS radius */
+  double value; /**< the fitted A parameter of the Modified Gaussian density */
+};
+
+/**
+ * Persistent cache of the Modified Gaussian fits of ChargeDistributions::FitHODist,
+ * keyed by the fitter, proton number and RMS radius, so that builds with
+ * and without ROOT sharing a cache file never use each other's fits.
+ * The cache is a fixed-size open addressing hash table in a memory-mapped
+ * file, which can be shared by any number of processes. Lookups hold a shared
+ * and stores an exclusive advisory lock on the file, so that no process reads
+ * a partially written entry. A file which cannot be opened or mapped only
+ * disables the cache.
+ */
+class FitCache {
+ public:
+  /**
+   * Constructor, opens or creates the cache file
+   *
+   * @param filename path of the cache file
+   */
+  FitCache(std::string filename);
+  ~FitCache();
+  FitCache(const FitCache&) = delete;
+  FitCache& operator=(const FitCache&) = delete;
+
+  inline bool IsOpen() const { return entries != nullptr; };
+
+  /**
+   * Look up a fit
+   *
+   * @param fitter the ChargeDistributions::HOFitter which performed the fit
+   * @param Z the proton number
+   * @param rms the RMS radius
+   * @param value set to the fitted value when found
+   * @returns whether the fit was found
+   */
+  bool Lookup(int fitter, int Z, double rms, double& value) const;
+  /**
+   * Store a fit. Nothing is stored when the table is full.
+   *
+   * @param fitter the ChargeDistributions::HOFitter which performed the fit
+   * @param Z the proton number
+   * @param rms the RMS radius
+   * @param value the fitted value
+   */
+  void Store(int fitter, int Z, double rms, double value);
+
+  /**
+   * Number of entries in a cache file. Changing it, the entry layout or the
+   * fit itself requires a new version, after which older files are replaced.
+   */
+  static const std::size_t capacity = 1 << 14;
+  static const std::uint32_t version = 2;
+
+ private:
+  FitCacheEntry* Find(std::uint64_t key, int fitter, int Z, double rms) const;
+
+  int fd = -1; /**< descriptor of the cache file */
+  void* map = nullptr; /**< start of the mapped file */
+  std::size_t mapSize = 0; /**< size of the mapped file */
+  FitCacheEntry* entries = nullptr; /**< the hash table in the mapped file */
+};
+
+}
+
+#endif
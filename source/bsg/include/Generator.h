@@ -4,14 +4,62 @@
 #include <vector>
 #include <string>
 #include <tuple>
+#include <memory>
+#include <mutex>
+#include <cmath>
+#include <cstdint>
+#include <functional>
 #include "NuclearStructureManager.h"
 #include "NuclearUtilities.h"
+#include "CorrectionPlan.h"
+#include "CorrectionProfile.h"
+#include "GeneratorConfig.h"
+#include "RawSpectrumWriter.h"
+#include "Spectrum.h"
+#include "SpectrumScan.h"
+#include "SpectrumSampler.h"
+#include "SpectrumInterpolant.h"
 #include "spdlog/spdlog.h"
 
 namespace bsg {
 
+/**
+ * Result of an adaptive integration of the spectrum
+ */
+struct SpectrumIntegral {
+  int moment; /**< the power of W weighting the electron spectrum */
+  double value; /**< the integral of W^moment dN/dW */
+  double error; /**< estimated absolute error on value */
+  std::size_t evaluations; /**< number of evaluations of the decay rate */
+};
+
+/**
+ * Transition parameters which can be varied without repeating the setup of a
+ * Generator, such as the charge distribution fit and the nuclear structure
+ * calculation
+ */
+struct TransitionParameters {
+  double W0; /**< the total endpoint energy in units of the electron rest mass */
+  double R; /**< the nuclear radius in natural units */
+  double daughterBeta2; /**< the quadrupole deformation of the daughter nucleus */
+  double fb, fd; /**< weak magnetism and induced tensor form factors */
+  double ratioM121; /**< the ratio of matrix elements M121/M101 */
+  double mixingRatio; /**< the mixing ratio of Fermi vs Gamow-Teller decay */
+};
+
+/**
+ * Distribution of the deviation of a transition parameter from its nominal
+ * value, used to propagate input uncertainties to the spectrum
+ */
+struct ParameterDistribution {
+  std::string name; /**< name of the varied option */
+  enum Shape { NORMAL, UNIFORM } shape; /**< the shape of the distribution */
+  double width; /**< the standard deviation or the half width, in the units of the option */
+};
+
 class Generator {
  private:
+  GeneratorConfig config; /**< the options of this transition */
   /**
    * Enum to distinguish beta+/-
    */
@@ -29,7 +77,7 @@ class Generator {
   double A;   /**< Mass number */
   double Z;   /**< the proton number of the daughter nucleus */
   double mixingRatio; /**< the mixing ratio of Fermi vs Gamow-Teller decay */
-  double hoFit; /**< the fit value obtained after fitting the nuclear charge distribution with a Modified Gaussian */
+  double hoFit = 0.; /**< the fit value obtained after fitting the nuclear charge distribution with a Modified Gaussian */
   double daughterBeta2; /**< the quadrupole deformation of the daughter nucleus */
   double motherBeta2; /**< the quadrupole deofrmation of the mother nucleus */
   double motherExcitationEn; /**< the excitation energy in keV of the mother state */
@@ -46,21 +94,37 @@ class Generator {
 
   nme::NuclearStructure::SingleParticleState spsi, spsf; /**< single particle states calculated from the NME library and used in the C_I correction when turned on */
 
-  nme::NuclearStructure::NuclearStructureManager* nsm; /**< pointer to the nuclear structure manager */
+  nme::NuclearStructure::NuclearStructureManager* nsm = nullptr; /**< pointer to the nuclear structure manager, constructed on first use */
 
-  std::vector<std::vector<double> >* spectrum; /**< vector of vectors containing the calculated spectrum */
+  Spectrum spectrum; /**< the calculated spectrum */
+  std::vector<SpectrumIntegral> integrals; /**< adaptive integrals of the spectrum, filled instead of spectrum in integral-only mode */
+
+  CorrectionPlan correctionPlan; /**< enabled spectral corrections with all transition constants bound */
+#ifdef BSG_PROFILE_CORRECTIONS
+  CorrectionProfile correctionProfile; /**< time spent per correction during the last CalculateSpectrum */
+
+  /**
+   * Write the time spent per correction to the .log file and to a
+   * .timing.json sidecar
+   */
+  void WriteCorrectionProfile();
+#endif
 
   /// recoil correction form factors
-  double fb, fc1, fd, ratioM121;
-  double bAc, dAc;
+  double fb = 0., fc1 = 1., fd = 0., ratioM121 = 0.;
+  double bAc = 0., dAc = 0.;
+  bool matrixElementsCalculated = false; /**< whether the form factors above were calculated or taken from the options */
+
+  std::once_flag hoFitFlag, l0Flag, matrixElementsFlag; /**< guards of the dependencies which are set up on first use */
   double gA, gP, gM; /**< coupling constants of the weak Hamiltonian */
 
   std::shared_ptr<spdlog::logger> consoleLogger;
   std::shared_ptr<spdlog::logger> debugFileLogger;
-  std::shared_ptr<spdlog::logger> rawSpectrumLogger;
   std::shared_ptr<spdlog::logger> resultsFileLogger;
+  std::unique_ptr<RawSpectrumWriter> rawSpectrumWriter; /**< background writer of the .raw file, null without output files */
 
   std::string outputName;
+  bool writeFiles = true; /**< false when the output is none, which discards the logs and writes no files */
 
   /**
    * Calculate the required nuclear matrix elements if they are not given from the commandline
@@ -71,6 +135,22 @@ class Generator {
    * Initialize the hard-coded parameters aNeq and aPos for the Wilkinson L0 correction
    */
   void InitializeL0Constants();
+
+  /**
+   * Fit the charge distribution with a Modified Gaussian, or take the fit from
+   * Spectrum.ModGaussFit, the first time it is needed
+   */
+  void RequireHOFit();
+  /**
+   * Initialize the constants of the L0 correction the first time they are needed
+   */
+  void RequireL0Constants();
+  /**
+   * Calculate the nuclear matrix elements and form factors the first time
+   * they are needed. The nuclear structure manager is only constructed when
+   * b/Ac, d/Ac or M121/M101 is not given.
+   */
+  void RequireMatrixElements();
   /**
    * Load the fit parameters of the atomic exchange correction from a file
    */
@@ -81,6 +161,16 @@ class Generator {
    */
   void InitializeConstants();
 
+  /**
+   * Get the A parameter of the Modified Gaussian fit to the harmonic
+   * oscillator charge distribution, from the fit cache when it was fitted
+   * before by any process
+   *
+   * @param Z the proton number
+   * @param rms the RMS radius in natural units
+   */
+  double GetHOFit(int Z, double rms);
+
   /**
    * Initialize all parameters related to the electrostatic shape
    */
@@ -96,26 +186,112 @@ class Generator {
    */
   void InitializeNSMInfo();
 
+  /**
+   * Resolve the spectrum options into the list of enabled corrections used in the energy loop
+   */
+  void InitializeCorrectionPlan();
+
   /**
    * Construct the output file
    */
   void PrepareOutputFile();
 
+
   /**
-   * Calculate the properly normalized ft value
-   * @param partialHalflife the halflife of the transition
+   * Get the integral of W^moment times the electron spectrum, from the
+   * adaptive integrals when available and from the sampled spectrum otherwise
+   *
+   * @param moment the power of W
    */
-  double CalculateLogFtValue(double partialHalflife);
+  double GetSpectrumMoment(int moment);
 
-  double CalculateMeanEnergy();
+  /**
+   * Get the range of total electron energies set by Spectrum.Begin and
+   * Spectrum.End
+   *
+   * @returns tuple of the first and last W
+   */
+  std::tuple<double, double> GetEnergyRange();
+  /**
+   * Build the grid of total electron energies between two energies with the
+   * step set by Spectrum.StepSize or Spectrum.Steps
+   *
+   * @param beginW the first total electron energy
+   * @param endW the last total electron energy
+   */
+  std::vector<double> BuildGrid(double beginW, double endW);
+  /**
+   * Calculate the total endpoint energy for a Q value, including the atomic
+   * energy deficit, excitation energies and recoil
+   *
+   * @param QValue the Q value in keV
+   */
+  double CalculateEndpoint(double QValue) const;
+
+  /**
+   * Add the C correction for the given transition parameters to a
+   * correction plan, or replace it when the plan already contains one
+   *
+   * @param plan the correction plan
+   * @param p the transition parameters
+   */
+  void SetCCorrection(CorrectionPlan& plan, const TransitionParameters& p);
+  /**
+   * Get the current values of the transition parameters
+   */
+  TransitionParameters GetTransitionParameters() const;
+  /**
+   * Build the plan of enabled corrections for the given transition
+   * parameters, reusing everything else which was set up for the transition.
+   * The plan does not refer back to the Generator.
+   *
+   * @param p the transition parameters
+   */
+  CorrectionPlan BuildCorrectionPlan(const TransitionParameters& p);
+  /**
+   * Bind the enabled corrections for the given transition parameters into a
+   * correction plan. When the plan was built for other parameters, only the
+   * corrections depending on a parameter which differs are bound again, in
+   * place, and all others are kept.
+   *
+   * @param plan the correction plan
+   * @param p the transition parameters
+   * @param previous the transition parameters of plan, or nullptr to bind
+   * every correction into an empty plan
+   */
+  void BindCorrections(CorrectionPlan& plan, const TransitionParameters& p,
+                       const TransitionParameters* previous = nullptr);
+  /**
+   * Draw one sample of the transition parameters. Sample i uses a fixed
+   * position of a counter-based random number stream, so that it does not
+   * depend on the order in which samples are drawn.
+   *
+   * @param distributions the distributions of the varied parameters
+   * @param seed the seed of the random number stream
+   * @param sample the index of the sample
+   * @param deviations filled with the deviation of every varied parameter
+   */
+  TransitionParameters SampleTransitionParameters(const std::vector<ParameterDistribution>& distributions,
+                                                  uint64_t seed, std::size_t sample,
+                                                  std::vector<double>& deviations) const;
 
  public:
   /**
    * Constructor for Generator.
-   * Performs the full initialization of the Generator by fetching arguments
-   * from the commandline or config file, performing the L0 initialization and charge distribution fitting
+   * Initializes the Generator by fetching arguments from the commandline or
+   * config file. The L0 initialization, charge distribution fit and nuclear
+   * structure calculation are only performed when the enabled corrections
+   * need them.
    */
   Generator();
+  /**
+   * Constructor for Generator using a given set of options instead of those
+   * of the option containers. Generators constructed this way are
+   * independent of each other.
+   *
+   * @param config the options of the transition
+   */
+  Generator(const GeneratorConfig& config);
   /**
    * Destructor for Generator.
    * Deletes the reference to the nuclear structure manager
@@ -125,16 +301,175 @@ class Generator {
   /**
    * Calculates the beta spectrum by filling the spectrum variable.
    *
-   * @returns spectrum variable
+   * @returns spectrum variable, owned by the Generator
+   */
+  const Spectrum& CalculateSpectrum();
+  /**
+   * Calculates f, the mean energy and the higher moments of the spectrum up
+   * to Spectrum.Moments with adaptive Gauss-Kronrod quadrature to the
+   * relative tolerance Spectrum.Tolerance, without sampling the spectrum on
+   * a fixed grid.
+   *
+   * @returns the integrals of W^k dN/dW for k = 0, ..., Spectrum.Moments
+   */
+  const std::vector<SpectrumIntegral>& CalculateIntegrals();
+  /**
+   * Integrate W^moment times the electron spectrum over the energy range
+   * with adaptive Gauss-Kronrod quadrature
+   *
+   * @param moment the power of W
+   * @param tolerance the requested relative accuracy
+   */
+  SpectrumIntegral IntegrateSpectrum(int moment, double tolerance);
+  /**
+   * Prepare a scan of one of the parameters entering the spectrum linearly,
+   * i.e. Spectrum.WeakMagnetism (b/Ac), Spectrum.InducedTensor (d/Ac) or
+   * Spectrum.Lambda (M121/M101), on the usual grid. All other corrections are
+   * calculated only once.
+   *
+   * @param parameter name of the option to scan
+   * @returns the spectrum as a function of the parameter
+   */
+  SpectrumScan PrepareScan(std::string parameter);
+  /**
+   * Scan a parameter over a range of values and write the log f(t) value and
+   * mean energy for every value to the .scan file
+   *
+   * @param scan description of the form Parameter=begin:end:steps
+   */
+  void CalculateScan(std::string scan);
+  /**
+   * Propagate the uncertainties of the transition parameters given with
+   * MC.Parameter by calculating MC.Samples spectra with randomly drawn
+   * parameters. The setup of the transition, i.e. the charge distribution fit
+   * and the nuclear matrix elements, is shared by all samples.
+   * The mean and standard deviation of the spectrum are written to the .mc
+   * file, and the drawn parameters with their log f(t) and mean energy to the
+   * .mc.samples file. Results do not depend on the number of threads.
+   */
+  void CalculateUncertainties();
+  /**
+   * Get a sampler of electron or neutrino energies from the spectrum,
+   * calculating the spectrum first if needed
+   *
+   * @param neutrino sample neutrino instead of electron energies
    */
-  std::vector<std::vector<double> >* CalculateSpectrum();
+  SpectrumSampler GetSampler(bool neutrino = false);
   /**
-   * Calculate the decay rate at energy W
+   * Get the cumulative distribution of the electron or neutrino energies
+   * between two energies, calculated independently of the tabulated spectrum.
+   * The spectrum is integrated with QAGS, as in IntegrateSpectrum, over 1000
+   * equal intervals, and the distribution is interpolated between them with
+   * cubic Hermite polynomials using the spectrum itself as derivative.
+   *
+   * @param beginW the lowest total energy in units of the electron rest mass
+   * @param endW the highest total energy in units of the electron rest mass
+   * @param neutrino use the neutrino instead of the electron spectrum
+   */
+  std::function<double(double)> BuildReferenceCdf(double beginW, double endW, bool neutrino);
+  /**
+   * Sample Sampler.Events energies from the spectrum on Spectrum.Threads
+   * threads and stream them to the .events file in blocks. The first
+   * Sampler.Test energies are compared with the distribution of
+   * BuildReferenceCdf in a Kolmogorov-Smirnov test.
+   */
+  void GenerateEvents();
+  /**
+   * Calculate the decay rate at energy W and write it to the .raw file
    *
    * @param W the total electron energy in units of its rest mass
    * @returns the decay rate at energy W
    */
   std::tuple<double, double> CalculateDecayRate(double W);
+  /**
+   * Evaluate the electron and neutrino decay rates for an array of energies.
+   * Nothing is logged or written to file and the Generator is not modified,
+   * so that a single Generator can be evaluated from many threads at once.
+   *
+   * @param W total electron energies in units of its rest mass
+   * @param electron view of the same length as W to be filled with the electron decay rates
+   * @param neutrino view of the same length as W to be filled with the neutrino decay rates
+   */
+  void Evaluate(Span<const double> W, Span<double> electron,
+                Span<double> neutrino) const;
+
+  /**
+   * Calculate the properly normalized ft value
+   * @param partialHalflife the halflife of the transition
+   */
+  double CalculateLogFtValue(double partialHalflife);
+  /**
+   * Calculate the mean total electron energy in units of its rest mass from
+   * the calculated spectrum or integrals
+   */
+  double CalculateMeanEnergy();
+  /**
+   * Check whether a spectrum or its integrals were calculated, which
+   * CalculateLogFtValue and CalculateMeanEnergy require
+   */
+  inline bool HasSpectrum() const { return !spectrum.IsEmpty() || !integrals.empty(); };
+
+  inline double GetWeakMagnetism() { RequireMatrixElements(); return bAc; };
+  inline double GetInducedTensor() { RequireMatrixElements(); return dAc; };
+  inline std::string GetOutputName() const { return outputName; };
+  inline const GeneratorConfig& GetConfig() const { return config; };
+  inline const CorrectionPlan& GetCorrectionPlan() const { return correctionPlan; };
+  /**
+   * Calculate the coefficients of Wilkinson's fit of the L0 correction, as
+   * used by every Generator
+   *
+   * @param Z the proton number of the daughter nucleus
+   * @param aPos array to be filled with the coefficients for beta+ decay
+   * @param aNeg array to be filled with the coefficients for beta- decay
+   */
+  static void CalculateL0Coefficients(double Z, double aPos[7], double aNeg[7]);
+  /**
+   * Look up the fit coefficients of the atomic exchange correction of an
+   * atom in an exchange parameters file
+   *
+   * @param exParamFile path to the exchange parameters file
+   * @param Z the proton number of the atom, i.e. of the mother nucleus
+   * @param exPars array to be filled with the nine fit coefficients
+   * @returns whether the file contains the atom
+   */
+  static bool GetExchangeParameters(const std::string& exParamFile, int Z, double exPars[9]);
+
+  inline int GetProtonNumber() const { return (int)Z; };
+  /**
+   * Get the RMS radius of the daughter nucleus in natural units
+   */
+  inline double GetRMSRadius() const { return R * std::sqrt(3. / 5.); };
+  /**
+   * Build the grid of total electron energies set by Spectrum.Begin,
+   * Spectrum.End and Spectrum.StepSize or Spectrum.Steps
+   */
+  std::vector<double> BuildGrid();
+  /**
+   * Build the plan of enabled corrections from the full-argument spectral
+   * functions, which evaluate the original expressions point by point
+   * without prepared constants, batch kernels or tables. Used to validate
+   * the plan of BuildCorrectionPlan.
+   */
+  CorrectionPlan BuildReferenceCorrectionPlan();
+  /**
+   * Build the interpolant of the electron and neutrino decay rates between
+   * two energies, with the relative tolerance Spectrum.Tolerance
+   *
+   * @param beginW the first total electron energy
+   * @param endW the last total electron energy
+   * @param nThreads number of threads
+   */
+  SpectrumInterpolant BuildSpectrumInterpolant(double beginW, double endW, int nThreads);
+  inline const Spectrum& GetSpectrum() const { return spectrum; };
+  /**
+   * Move the calculated spectrum out of the Generator, so that its buffers
+   * can be handed to another owner without copying
+   */
+  inline Spectrum ReleaseSpectrum() { return std::move(spectrum); };
+  /**
+   * Get the nuclear structure manager, constructing it on first use
+   */
+  nme::NuclearStructure::NuclearStructureManager* GetNuclearStructureManager();
 
   inline void SetOutputName(std::string _output) { outputName = _output; };
 };
@@ -0,0 +1,120 @@
+#ifndef GENERATORCONFIG
+#define GENERATORCONFIG
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <boost/program_options/variables_map.hpp>
+
+namespace bsg {
+
+namespace po = boost::program_options;
+
+/**
+ * All options of a single transition, i.e. the spectral and transition options
+ * used by the Generator and the options of the nuclear structure calculation.
+ * A GeneratorConfig is a plain value: it is either copied from the option
+ * containers or built up programmatically, after which every Generator reads
+ * only its own copy.
+ */
+class GeneratorConfig {
+ public:
+  GeneratorConfig() {};
+  /**
+   * Constructor
+   *
+   * @param bsgOptions the options of the BSGOptionContainer
+   * @param nmeOptions the options of the NMEOptionContainer
+   */
+  GeneratorConfig(po::variables_map bsgOptions, po::variables_map nmeOptions)
+      : bsgOptions(bsgOptions), nmeOptions(nmeOptions) {};
+
+  /**
+   * Copy the options which were parsed from the commandline, configuration
+   * and input files by the option containers for the calling thread
+   */
+  static GeneratorConfig FromOptions();
+
+  /**
+   * Read the transition information from an input file, as with --input.
+   * Options which were already set explicitly are kept.
+   *
+   * @param inputName the path to the input file
+   * @returns false if the file cannot be opened
+   */
+  bool ReadInput(std::string inputName);
+  /**
+   * Read the spectral and computational options from a configuration file,
+   * as with --config. Options which were already set explicitly are kept.
+   *
+   * @param configName the path to the configuration file
+   * @returns false if the file cannot be opened
+   */
+  bool ReadConfig(std::string configName);
+
+  /**
+   * Get an option
+   *
+   * @template T variable type
+   * @param name variable name
+   */
+  template <typename T>
+  T Get(std::string name) const {
+    try {
+      return bsgOptions[name].as<T>();
+    } catch (boost::bad_any_cast& e) {
+      std::cerr << "BSG ERROR: Option \"" << name << "\" not defined. " << std::endl;
+      throw e;
+    }
+  }
+  /**
+   * Check whether an option was given
+   *
+   * @param name variable name
+   */
+  inline bool Exists(std::string name) const { return (bool)bsgOptions.count(name); };
+  /**
+   * Set an option for both the spectrum and the nuclear structure
+   * calculation, replacing any earlier value
+   *
+   * @template T variable type
+   * @param name variable name
+   * @param value the new value
+   */
+  template <typename T>
+  void Set(std::string name, T value) {
+    SetOption(bsgOptions, name, boost::any(value));
+    SetOption(nmeOptions, name, boost::any(value));
+  }
+
+  /**
+   * Set a transition, spectrum, configuration or generic option, such as
+   * output, from its text
+   * representation, as it would appear in an input or configuration file,
+   * replacing any earlier value
+   *
+   * @param name variable name
+   * @param values the value, or one value per element of a multitoken option
+   * @returns false if the option is unknown or a value cannot be converted
+   */
+  bool Override(std::string name, std::vector<std::string> values);
+
+  /**
+   * Format all options as name=value lines, so that two configurations
+   * resulting in the same calculation give the same text
+   */
+  std::string ToString() const;
+
+  inline const po::variables_map& GetBSGOptions() const { return bsgOptions; };
+  inline const po::variables_map& GetNMEOptions() const { return nmeOptions; };
+
+ private:
+  static void SetOption(po::variables_map& vm, std::string name, boost::any value);
+
+  po::variables_map bsgOptions; /**< spectral and transition options */
+  po::variables_map nmeOptions; /**< nuclear structure options */
+};
+
+}
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef RAWSPECTRUMWRITER
+#define RAWSPECTRUMWRITER
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "Utilities.h"
+
+namespace bsg {
+
+/**
+ * A single line of the raw spectrum
+ */
+struct RawSpectrumRecord {
+  double W; /**< total electron energy in units of its rest mass */
+  double E; /**< kinetic electron energy in keV */
+  double electron; /**< electron decay rate */
+  double neutrino; /**< neutrino decay rate */
+};
+
+/**
+ * Writer of the raw spectrum file running on a background thread.
+ * Records are handed over through a lock-free queue, so that the energy loop
+ * does no formatting or I/O. While the queue is empty the background thread
+ * sleeps on a condition variable, and it is only woken by Push, Flush or the
+ * destructor. The text layout has one tab separated line per
+ * record, the binary layout four little-endian IEEE-754 doubles per record in
+ * the order of RawSpectrumRecord.
+ */
+class RawSpectrumWriter {
+ public:
+  enum Format { TEXT, BINARY };
+
+  /**
+   * Constructor, opens the file and starts the background thread
+   *
+   * @param filename name of the raw spectrum file
+   * @param format the layout of the file
+   * @param capacity number of records which can be waiting in the queue
+   */
+  RawSpectrumWriter(std::string filename, Format format,
+                    std::size_t capacity = 1 << 16);
+  /**
+   * Destructor, writes all remaining records and closes the file
+   */
+  ~RawSpectrumWriter();
+
+  /**
+   * Queue a record for writing. Waits only when the queue is full.
+   *
+   * @param W the total electron energy in units of its rest mass
+   * @param electron the electron decay rate
+   * @param neutrino the neutrino decay rate
+   */
+  void Push(double W, double electron, double neutrino);
+  /**
+   * Wait until all queued records are written and flush the file
+   */
+  void Flush();
+
+  inline Format GetFormat() const { return format; };
+
+ private:
+  void Run();
+  void Write(const RawSpectrumRecord& record);
+
+  std::FILE* file;
+  Format format;
+  utilities::LockFreeQueue<RawSpectrumRecord> queue;
+  std::atomic<std::size_t> pushed{0};
+  std::atomic<std::size_t> written{0};
+  std::atomic<bool> done{false};
+  std::atomic<bool> sleeping{false}; /**< the background thread waits for records */
+  std::atomic<bool> flushing{false}; /**< Flush waits for the queue to drain */
+  std::mutex mutex;
+  std::condition_variable wakeup; /**< signalled when records are pushed */
+  std::condition_variable drained; /**< signalled when all records are written */
+  std::thread worker;
+};
+
+}
+
+#endif
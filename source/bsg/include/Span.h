@@ -0,0 +1,47 @@
+#ifndef SPAN
+#define SPAN
+
+#include <cstddef>
+#include <vector>
+
+namespace bsg {
+
+/**
+ * Non-owning view of a contiguous array, following std::span from C++20
+ */
+template <typename T>
+class Span {
+ public:
+  Span() : ptr(nullptr), n(0) {};
+  Span(T* ptr, std::size_t n) : ptr(ptr), n(n) {};
+  /**
+   * Conversion from a view of non-const to a view of const elements
+   */
+  template <typename U>
+  Span(const Span<U>& other) : ptr(other.data()), n(other.size()) {};
+  template <typename U>
+  Span(std::vector<U>& v) : ptr(v.data()), n(v.size()) {};
+  template <typename U>
+  Span(const std::vector<U>& v) : ptr(v.data()), n(v.size()) {};
+
+  inline T* data() const { return ptr; };
+  inline std::size_t size() const { return n; };
+  inline bool empty() const { return n == 0; };
+  inline T* begin() const { return ptr; };
+  inline T* end() const { return ptr + n; };
+  inline T& operator[](std::size_t i) const { return ptr[i]; };
+  /**
+   * View of count elements starting at offset
+   */
+  inline Span<T> subspan(std::size_t offset, std::size_t count) const {
+    return Span<T>(ptr + offset, count);
+  };
+
+ private:
+  T* ptr;
+  std::size_t n;
+};
+
+}
+
+#endif
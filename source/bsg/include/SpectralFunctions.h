@@ -6,9 +6,12 @@
 #include <vector>
 #include <gsl/gsl_complex.h>
 #include <tuple>
+#include <cstddef>
+#include <cmath>
 
 #include "Constants.h"
 #include "NuclearUtilities.h"
+#include "Utilities.h"
 
 namespace bsg {
 
@@ -174,7 +177,7 @@ double RelativisticCorrection(double W, double W0, int Z, int A, double R,
                               int betaType, int decayType);
 
 /**
- * Deformation correction to L0
+ * Deformation correction to L0, which is 1 for a spherical nucleus
  *
  * @param W electron total energy in units of its rest mass
  * @param W0 total endpoint energy in units of the electron rest mass
@@ -308,7 +311,7 @@ double AtomicScreeningCorrection(double W, int Z, int betaType);
  * @param W electron total energy in units of its rest mass
  * @param exPars array containing the 9 fit parameters required for the analytical parametrisation
  */
-double AtomicExchangeCorrection(double W, double exPars[9]);
+double AtomicExchangeCorrection(double W, const double exPars[9]);
 
 /**
  * Correction due to the mismatch between initial and final atomic states, causing the
@@ -335,6 +338,553 @@ double AtomicMismatchCorrection(double W, double W0, int Z, int A,
  *\sum_{k=1}^{k=\infty}\frac{x^k}{k^2} \equiv -\mathrm{Li}_2(x) \f]
  */
 double Spence(double x);
+
+/**
+ * @defgroup PreparedCorrections Corrections split in a prepare and an evaluate step
+ *
+ * The Prepare functions collect all quantities which depend only on the
+ * transition in an immutable struct. Evaluating a correction at an energy W
+ * using such a struct only costs a handful of additions and multiplications.
+ * The per-point functions with the full argument list above evaluate the
+ * original expressions directly, without prepared constants, and serve as the
+ * reference the prepared functions are validated against.
+ * @{
+ */
+
+/**
+ * Transition constants of the Fermi function
+ */
+struct FermiFunctionConstants {
+  double gamma; /**< \f$ \sqrt{1-(\alpha Z)^2} \f$ */
+  double first; /**< \f$ 2(\gamma+1) \f$ */
+  double lnGamma; /**< \f$ \ln \Gamma(2\gamma+1) \f$ */
+  double twoR; /**< twice the nuclear radius */
+  double alphaZ; /**< \f$ \pm \alpha Z \f$ */
+};
+
+/**
+ * Prepare the Fermi function for a transition
+ *
+ * @param Z the proton number of the daughter nucleus
+ * @param R the nuclear radius in natural units
+ * @param betaType BetaType of the transition
+ * @see FermiFunction
+ */
+FermiFunctionConstants PrepareFermiFunction(int Z, double R, int betaType);
+
+/**
+ * Fermi function using prepared transition constants
+ *
+ * @param W the total electron energy in units of the electron rest mass
+ * @param c the prepared transition constants
+ */
+double FermiFunction(double W, const FermiFunctionConstants& c);
+
+/**
+ * Transition constants of the C correction. The shape part is
+ * \f$ 1 + C_0 + C_1 W + C_{-1}/W + C_2 W^2 \f$, the nuclear-sensitive part
+ * contains the induced pseudoscalar contribution proportional to phi.
+ */
+struct CCorrectionConstants {
+  bool shape; /**< whether the shape part is defined for the decay type */
+  double C0, C1, Cm1, C2; /**< coefficients of the shape part */
+  double NSC0, NSC1, NSCm1, NSC2; /**< coefficients of the nuclear-sensitive part */
+  double phi, P0, P1, Pm1; /**< induced pseudoscalar coefficients */
+};
+
+/**
+ * Prepare the C correction for a transition. Arguments are those of
+ * CCorrectionComponents.
+ *
+ * @see CCorrectionComponents
+ */
+CCorrectionConstants PrepareCCorrection(double W0, int Z, int A, double R,
+                                        int betaType, int decayType, double gA,
+                                        double gP, double fc1, double fb,
+                                        double fd, double ratioM121,
+                                        std::string NSShape, double hoFit);
+
+/**
+ * Transition constants of the isovector correction to the C correction,
+ * written as \f$ (a_0 - a_1 \epsilon)(1 + b_1 \epsilon) \f$ with
+ * \f$ \epsilon = [(W_0-W)^2 + (W+V_0)^2 - 1]/6 \f$.
+ * A default constructed struct corresponds to no correction.
+ */
+struct CICorrectionConstants {
+  double W0 = 1.; /**< total endpoint energy */
+  double V0 = 0.; /**< Coulomb potential at the origin */
+  double a0 = 1.;
+  double a1 = 0.;
+  double b1 = 0.;
+};
+
+/**
+ * Prepare the isovector correction using the simple shell model occupation
+ *
+ * @see CICorrection
+ */
+CICorrectionConstants PrepareCICorrection(double W0, int Z, int A, double R,
+                                          int betaType);
+
+/**
+ * Prepare the isovector correction using the single particle states of the
+ * initial and final nucleon
+ *
+ * @see CICorrection
+ */
+CICorrectionConstants PrepareCICorrection(
+    double W0, double Z, double R, int betaType,
+    nme::NuclearStructure::SingleParticleState& spsi,
+    nme::NuclearStructure::SingleParticleState& spsf);
+
+/**
+ * Shape and nuclear-sensitive parts of the C correction using prepared
+ * transition constants
+ *
+ * @param W the total electron energy in units of the electron rest mass
+ * @param c the prepared transition constants
+ */
+inline std::tuple<double, double> CCorrectionComponents(
+    double W, const CCorrectionConstants& c) {
+  double cShape = c.shape ? 1. + c.C0 + c.C1 * W + c.Cm1 / W + c.C2 * W * W : 0.;
+  double cNS = c.NSC0 + c.NSC1 * W + c.NSCm1 / W + c.NSC2 * W * W +
+               c.phi * (c.P0 + c.P1 * W + c.Pm1 / W);
+  return std::make_tuple(cShape, cNS);
+}
+
+/**
+ * Isovector correction using prepared transition constants
+ *
+ * @param W the total electron energy in units of the electron rest mass
+ * @param c the prepared transition constants
+ */
+inline double CICorrection(double W, const CICorrectionConstants& c) {
+  double epsilon = (sqr(c.W0 - W) + sqr(W + c.V0) - 1.) / 6.;
+  return (c.a0 - c.a1 * epsilon) * (1. + c.b1 * epsilon);
+}
+
+/**
+ * C correction using prepared transition constants
+ *
+ * @param W the total electron energy in units of the electron rest mass
+ * @param c the prepared transition constants
+ * @param ci the prepared isovector correction, default constructed if it is
+ * not to be included
+ */
+inline double CCorrection(double W, const CCorrectionConstants& c,
+                          const CICorrectionConstants& ci) {
+  double cShape, cNS;
+  std::tie(cShape, cNS) = CCorrectionComponents(W, c);
+  return cShape * CICorrection(W, ci) + cNS;
+}
+
+/**
+ * Transition constants of the relativistic matrix element correction
+ */
+struct RelativisticCorrectionConstants {
+  bool fermi; /**< the correction is only applied to Fermi transitions */
+  double W0, R;
+  double V0; /**< Coulomb potential at the origin */
+  double gamma; /**< \f$ \sqrt{1-(\alpha Z)^2} \f$ */
+  double mismatch; /**< the factor multiplying the form factor ratios */
+  double D3c; /**< W-independent term of D3 */
+};
+
+/**
+ * Prepare the relativistic matrix element correction for a transition
+ *
+ * @see RelativisticCorrection
+ */
+RelativisticCorrectionConstants PrepareRelativisticCorrection(
+    double W0, int Z, int A, double R, int betaType, int decayType);
+
+/**
+ * Relativistic matrix element correction using prepared transition constants
+ *
+ * @param W the total electron energy in units of the electron rest mass
+ * @param c the prepared transition constants
+ */
+inline double RelativisticCorrection(double W,
+                                     const RelativisticCorrectionConstants& c) {
+  if (!c.fermi) return 1.;
+  double R = c.R;
+  double Wb = W + c.V0;
+  double pbR = std::sqrt(Wb * Wb - 1.) * R;
+  double pbR2 = pbR * pbR;
+  double H2 = -pbR2 / 6.;
+  double D1 = Wb * R / 3.;
+  double D3 = -Wb * R * pbR2 / 30 - c.D3c;
+  double d1 = R / 3.;
+  double d3 = -R * pbR2 / 30.;
+  double q = (c.W0 - W) * R;
+  double N1 = q / 3.;
+  double N2 = -(q * q) / 6.;
+  double N3 = q * q * q / 30;
+
+  double Vf2 = -2. * (D1 + N1) + 2 * c.gamma / W * d1;
+  double Vf3 =
+      -2. * (D3 + N1 * H2 - N2 * D1 - N3) + 2 * c.gamma / W * (d3 - N2 * d1);
+
+  return 1. - 3. / 10 * R * c.mismatch * Vf2 - 3. / 28. * R * c.mismatch * Vf3;
+}
+
+/**
+ * Transition constants of the deformation correction. The correction is
+ * tabulated once on [1, W0], which covers both the electron and the neutrino
+ * energies, and is calculated directly elsewhere. The table is only kept if
+ * its deviation from the direct integral, checked halfway between the nodes
+ * of every piece, is below the tolerance. bsg_validate reports the remaining
+ * deviation over a whole spectrum.
+ */
+struct DeformationCorrectionConstants {
+  double W0, R, beta2;
+  int Z, betaType;
+  double aPos[7], aNeg[7];
+  utilities::PiecewiseChebyshev table; /**< interpolant on [1, W0] */
+};
+
+/**
+ * Prepare the deformation correction for a transition
+ *
+ * @param tolerance the largest absolute interpolation error of the table
+ * @see DeformationCorrection
+ */
+DeformationCorrectionConstants PrepareDeformationCorrection(
+    double W0, int Z, double R, double beta2, int betaType,
+    const double aPos[], const double aNeg[], double tolerance = 1e-8);
+
+/**
+ * Deformation correction using prepared transition constants
+ *
+ * @param W the total electron energy in units of the electron rest mass
+ * @param c the prepared transition constants
+ */
+double DeformationCorrection(double W, const DeformationCorrectionConstants& c);
+
+/**
+ * Transition constants of the L0 correction at a fixed radius
+ */
+struct L0CorrectionConstants {
+  double r; /**< the radius at which the correction is evaluated */
+  double a[7]; /**< fit coefficients for the beta type of the transition */
+  double constant; /**< W-independent terms */
+  double cW; /**< coefficient of the term linear in W */
+  double cWm1; /**< coefficient of the term proportional to 1/W */
+  double norm; /**< \f$ 2/(1+\gamma) \f$ */
+};
+
+/**
+ * Prepare the L0 correction for a transition
+ *
+ * @see L0Correction
+ */
+L0CorrectionConstants PrepareL0Correction(int Z, double r, int betaType,
+                                          const double aPos[],
+                                          const double aNeg[]);
+
+/**
+ * L0 correction using prepared transition constants
+ *
+ * @param W the total electron energy in units of the electron rest mass
+ * @param c the prepared transition constants
+ */
+inline double L0Correction(double W, const L0CorrectionConstants& c) {
+  const double* a = c.a;
+  double x = W * c.r;
+  double sum = a[1] + x * (a[2] + x * (a[3] + x * (a[4] + x * (a[5] + x * a[6]))));
+  return (c.constant - c.cW * W - c.cWm1 / W + sum + a[0] * c.r / W) * c.norm;
+}
+
+/**
+ * Transition constants of the U correction. The optional Fermi shape part is
+ * \f$ 1 + a_0 + a_1 p + a_2 p^2 \f$, the modified Gaussian part
+ * \f$ c_0 + c_1 W + c_{-1}/W - c_2 W^2 \f$.
+ */
+struct UCorrectionConstants {
+  double a0, a1, a2;
+  double c0, c1, cm1, c2;
+};
+
+/**
+ * Prepare the U correction for a transition
+ *
+ * @see UCorrection
+ */
+UCorrectionConstants PrepareUCorrection(int Z, double R, int betaType,
+                                        std::string ESShape,
+                                        const std::vector<double>& v,
+                                        const std::vector<double>& vp);
+
+/**
+ * U correction using prepared transition constants
+ *
+ * @param W the total electron energy in units of the electron rest mass
+ * @param c the prepared transition constants
+ */
+inline double UCorrection(double W, const UCorrectionConstants& c) {
+  double p2 = W * W - 1;
+  double shape = 1. + c.a0 + c.a1 * std::sqrt(p2) + c.a2 * p2;
+  return shape * (c.c0 + c.c1 * W + c.cm1 / W - c.c2 * W * W);
+}
+
+/**
+ * Transition constants of the Coulomb recoil correction
+ */
+struct QCorrectionConstants {
+  double W0;
+  double c; /**< \f$ \pm \pi \alpha Z / M \f$ */
+  double d; /**< \f$ a / 3M \f$ */
+};
+
+/**
+ * Prepare the Coulomb recoil correction for a transition
+ *
+ * @see QCorrection
+ */
+QCorrectionConstants PrepareQCorrection(double W0, int Z, int A, int betaType,
+                                        int decayType, double mixingRatio);
+
+/**
+ * Coulomb recoil correction using prepared transition constants
+ *
+ * @param W the total electron energy in units of the electron rest mass
+ * @param c the prepared transition constants
+ */
+inline double QCorrection(double W, const QCorrectionConstants& c) {
+  double p = std::sqrt(W * W - 1.);
+  return 1. - c.c / p * (1. + c.d * (c.W0 - W));
+}
+
+/**
+ * Transition constants of the radiative correction. All orders beyond the
+ * first are combined in \f$ K + m_1 \ln 2W + m_2 \ln^2 2W \f$.
+ */
+struct RadiativeCorrectionConstants {
+  double W0;
+  double g0; /**< W-independent part of the first order correction */
+  double K, m1, m2;
+};
+
+/**
+ * Prepare the radiative correction for a transition
+ *
+ * @see RadiativeCorrection
+ */
+RadiativeCorrectionConstants PrepareRadiativeCorrection(double W0, int Z,
+                                                        double R, int betaType,
+                                                        double gA, double gM);
+
+/**
+ * Radiative correction using prepared transition constants
+ *
+ * @param W the total electron energy in units of the electron rest mass
+ * @param c the prepared transition constants
+ */
+double RadiativeCorrection(double W, const RadiativeCorrectionConstants& c);
+
+/**
+ * Transition constants of the kinematic recoil correction, written as
+ * \f$ 1 + c_0 + c_{-1}/W + c_1 W + c_2 W^2 \f$
+ */
+struct RecoilCorrectionConstants {
+  double c0, cm1, c1, c2;
+};
+
+/**
+ * Prepare the kinematic recoil correction for a transition
+ *
+ * @see RecoilCorrection
+ */
+RecoilCorrectionConstants PrepareRecoilCorrection(double W0, int A,
+                                                  int decayType,
+                                                  double mixingRatio);
+
+/**
+ * Kinematic recoil correction using prepared transition constants
+ *
+ * @param W the total electron energy in units of the electron rest mass
+ * @param c the prepared transition constants
+ */
+inline double RecoilCorrection(double W, const RecoilCorrectionConstants& c) {
+  return 1 + c.c0 + c.cm1 / W + c.c1 * W + c.c2 * W * W;
+}
+
+/**
+ * Transition constants of the atomic screening correction
+ */
+struct AtomicScreeningCorrectionConstants {
+  double l; /**< twice the amplitude weighted inverse screening length */
+  double gamma; /**< \f$ \sqrt{1-(\alpha Z)^2} \f$ */
+  double alphaZ; /**< \f$ \pm \alpha Z \f$ */
+  double V0; /**< the screening potential at the origin */
+};
+
+/**
+ * Prepare the atomic screening correction for a transition
+ *
+ * @see AtomicScreeningCorrection
+ */
+AtomicScreeningCorrectionConstants PrepareAtomicScreeningCorrection(
+    int Z, int betaType);
+
+/**
+ * Atomic screening correction using prepared transition constants
+ *
+ * @param W the total electron energy in units of the electron rest mass
+ * @param c the prepared transition constants
+ */
+double AtomicScreeningCorrection(double W,
+                                 const AtomicScreeningCorrectionConstants& c);
+
+/**
+ * Transition constants of the atomic mismatch correction
+ */
+struct AtomicMismatchCorrectionConstants {
+  double W0;
+  double dBdZ2; /**< second derivative of the atomic binding energy */
+  double lK; /**< \f$ 1.83\times10^{-3} K Z \f$ */
+  double vR; /**< average recoil velocity */
+  double alphaZ; /**< \f$ \alpha Z \f$ */
+};
+
+/**
+ * Prepare the atomic mismatch correction for a transition
+ *
+ * @see AtomicMismatchCorrection
+ */
+AtomicMismatchCorrectionConstants PrepareAtomicMismatchCorrection(
+    double W0, int Z, int A, int betaType);
+
+/**
+ * Atomic mismatch correction using prepared transition constants
+ *
+ * @param W the total electron energy in units of the electron rest mass
+ * @param c the prepared transition constants
+ */
+double AtomicMismatchCorrection(double W,
+                                const AtomicMismatchCorrectionConstants& c);
+/** @} */
+
+/**
+ * @defgroup BatchKernels Batch versions of the closed-form corrections
+ *
+ * Each batch kernel evaluates the correction of the same name for n
+ * contiguous energies W and writes n contiguous results. The loops use the
+ * inline evaluate functions of the prepared corrections and are compiled for
+ * AVX-512 and AVX2, with a scalar fallback selected at runtime.
+ * @{
+ */
+
+/**
+ * Batch version of the phase space factor
+ *
+ * @param W array of n total energies in units of the electron rest mass
+ * @param result array of n values to be filled
+ * @param n number of energies
+ * @see PhaseSpace
+ */
+void PhaseSpace(const double* W, double* result, std::size_t n, double W0,
+                int motherSpinParity, int daughterSpinParity);
+
+/**
+ * Batch version of the shape and nuclear-sensitive parts of the C correction
+ *
+ * @param W array of n total energies in units of the electron rest mass
+ * @param cShape array of n values to be filled with the shape part
+ * @param cNS array of n values to be filled with the nuclear-sensitive part
+ * @param n number of energies
+ * @param c the prepared transition constants
+ * @see CCorrectionComponents
+ */
+void CCorrectionComponents(const double* W, double* cShape, double* cNS,
+                           std::size_t n, const CCorrectionConstants& c);
+
+/**
+ * Batch version of the C correction including the isovector correction
+ *
+ * @param W array of n total energies in units of the electron rest mass
+ * @param result array of n values to be filled
+ * @param n number of energies
+ * @param c the prepared transition constants
+ * @param ci the prepared isovector correction
+ * @see CCorrection
+ */
+void CCorrection(const double* W, double* result, std::size_t n,
+                 const CCorrectionConstants& c,
+                 const CICorrectionConstants& ci);
+
+/**
+ * Batch version of the relativistic matrix element correction
+ *
+ * @param W array of n total energies in units of the electron rest mass
+ * @param result array of n values to be filled
+ * @param n number of energies
+ * @param c the prepared transition constants
+ * @see RelativisticCorrection
+ */
+void RelativisticCorrection(const double* W, double* result, std::size_t n,
+                            const RelativisticCorrectionConstants& c);
+
+/**
+ * Batch version of the L0 correction
+ *
+ * @param W array of n total energies in units of the electron rest mass
+ * @param result array of n values to be filled
+ * @param n number of energies
+ * @param c the prepared transition constants
+ * @see L0Correction
+ */
+void L0Correction(const double* W, double* result, std::size_t n,
+                  const L0CorrectionConstants& c);
+
+/**
+ * Batch version of the U correction
+ *
+ * @param W array of n total energies in units of the electron rest mass
+ * @param result array of n values to be filled
+ * @param n number of energies
+ * @param c the prepared transition constants
+ * @see UCorrection
+ */
+void UCorrection(const double* W, double* result, std::size_t n,
+                 const UCorrectionConstants& c);
+
+/**
+ * Batch version of the Coulomb recoil correction
+ *
+ * @param W array of n total energies in units of the electron rest mass
+ * @param result array of n values to be filled
+ * @param n number of energies
+ * @param c the prepared transition constants
+ * @see QCorrection
+ */
+void QCorrection(const double* W, double* result, std::size_t n,
+                 const QCorrectionConstants& c);
+
+/**
+ * Batch version of the kinematic recoil correction
+ *
+ * @param W array of n total energies in units of the electron rest mass
+ * @param result array of n values to be filled
+ * @param n number of energies
+ * @param c the prepared transition constants
+ * @see RecoilCorrection
+ */
+void RecoilCorrection(const double* W, double* result, std::size_t n,
+                      const RecoilCorrectionConstants& c);
+
+/**
+ * Batch version of the atomic exchange correction. Only the rational part is
+ * vectorised, the exponential and oscillating terms are evaluated per point.
+ *
+ * @param W array of n total energies in units of the electron rest mass
+ * @param result array of n values to be filled
+ * @param n number of energies
+ * @see AtomicExchangeCorrection
+ */
+void AtomicExchangeCorrection(const double* W, double* result, std::size_t n,
+                              const double exPars[9]);
+/** @} */
 }
 }
 
@@ -0,0 +1,53 @@
+#ifndef SPECTRUM
+#define SPECTRUM
+
+#include <cstddef>
+#include <vector>
+
+#include "Span.h"
+
+namespace bsg {
+
+/**
+ * Calculated beta spectrum stored as contiguous columns of the total electron
+ * energy W in units of its rest mass and the electron and neutrino decay
+ * rates at W
+ */
+class Spectrum {
+ public:
+  Spectrum() {};
+  /**
+   * Constructor taking ownership of the columns, which must have equal length
+   */
+  Spectrum(std::vector<double> W, std::vector<double> electron,
+           std::vector<double> neutrino);
+
+  inline std::size_t GetSize() const { return W.size(); };
+  inline bool IsEmpty() const { return W.empty(); };
+
+  inline Span<const double> GetW() const { return W; };
+  inline Span<const double> GetElectron() const { return electron; };
+  inline Span<const double> GetNeutrino() const { return neutrino; };
+  inline Span<double> GetElectron() { return electron; };
+  inline Span<double> GetNeutrino() { return neutrino; };
+
+  /**
+   * Integrate W^moment times the electron spectrum over W using Simpson's rule
+   *
+   * @param moment the power of W
+   */
+  double Integrate(int moment = 0) const;
+  /**
+   * Calculate the mean total electron energy in units of its rest mass
+   */
+  double CalculateMeanEnergy() const;
+
+ private:
+  std::vector<double> W; /**< total electron energies in units of its rest mass */
+  std::vector<double> electron; /**< electron decay rates */
+  std::vector<double> neutrino; /**< neutrino decay rates */
+};
+
+}
+
+#endif
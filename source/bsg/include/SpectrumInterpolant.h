@@ -0,0 +1,85 @@
+#ifndef SPECTRUMINTERPOLANT
+#define SPECTRUMINTERPOLANT
+
+#include "CorrectionPlan.h"
+#include "Utilities.h"
+
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace bsg {
+
+/**
+ * Interpolant of the full spectral shape, i.e. of the product of all
+ * corrections of a CorrectionPlan, for the electron and the neutrino.
+ * The logarithm of each decay rate is interpolated with a piecewise Chebyshev
+ * series, so that the absolute tolerance of the fit is a relative tolerance
+ * on the decay rates. The product is only evaluated at the Chebyshev nodes of
+ * every piece, and pieces are bisected until the tolerance is reached, which
+ * refines them geometrically towards the non-analytic points W = 1 and W0.
+ * Energies closer than 1e-4 (about 50 eV) to either of these, where a rate has
+ * dropped below 1e-30 of its value halfway, or which lie on a piece that did
+ * not reach the tolerance, e.g. around the branch point of the atomic
+ * screening correction, are evaluated directly.
+ */
+class SpectrumInterpolant {
+ public:
+  /**
+   * Constructor
+   *
+   * @param plan the corrections to interpolate, which must outlive the interpolant
+   * @param beginW the lowest total electron energy to interpolate
+   * @param endW the highest total electron energy to interpolate
+   * @param tolerance the relative interpolation error to reach
+   * @param nThreads number of threads, the electron and neutrino rates are fitted in parallel
+   */
+  SpectrumInterpolant(const CorrectionPlan& plan, double beginW, double endW,
+                      double tolerance, int nThreads = 1);
+
+  /**
+   * Evaluate the interpolated decay rates on a grid of energies. Energies
+   * outside of the interpolated range or on a piece which did not reach the
+   * tolerance are evaluated directly with the CorrectionPlan.
+   *
+   * @param W the grid of total electron energies in units of its rest mass
+   * @param electron vector to be filled with the electron decay rates
+   * @param neutrino vector to be filled with the neutrino decay rates
+   * @param nThreads number of threads
+   * @returns the number of energies which were evaluated directly
+   */
+  std::size_t Evaluate(const std::vector<double>& W,
+                       std::vector<double>& electron,
+                       std::vector<double>& neutrino, int nThreads) const;
+
+  /**
+   * Check whether the tolerance was reached on every piece of both decay rates
+   */
+  inline bool IsValid() const { return GetErrorEstimate() <= tolerance; };
+  inline std::size_t GetNumberOfPieces() const {
+    return logElectron.GetNumberOfPieces() + logNeutrino.GetNumberOfPieces();
+  };
+  /**
+   * Get the largest estimated relative interpolation error over all pieces,
+   * including those whose energies are evaluated directly
+   */
+  inline double GetErrorEstimate() const {
+    double e = logElectron.GetErrorEstimate(), v = logNeutrino.GetErrorEstimate();
+    return (std::isnan(e) || e > v) ? e : v;
+  };
+  /**
+   * Get the number of evaluations of the CorrectionPlan needed for the fit
+   */
+  inline std::size_t GetEvaluations() const { return evaluations; };
+
+ private:
+  const CorrectionPlan* plan;
+  utilities::PiecewiseChebyshev logElectron; /**< log of the electron decay rate */
+  utilities::PiecewiseChebyshev logNeutrino; /**< log of the neutrino decay rate */
+  double tolerance; /**< the relative interpolation error to reach */
+  std::size_t evaluations = 0;
+};
+
+}
+
+#endif
@@ -0,0 +1,102 @@
+#ifndef SPECTRUMSAMPLER
+#define SPECTRUMSAMPLER
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "Span.h"
+
+namespace bsg {
+
+/**
+ * Result of a Kolmogorov-Smirnov test of sampled energies
+ */
+struct GoodnessOfFit {
+  double statistic; /**< the largest distance between the sampled and expected distribution */
+  double pValue; /**< the probability of a larger distance for a correct sampler */
+  std::size_t n; /**< the number of tested energies */
+};
+
+/**
+ * Sampler of energies distributed according to a tabulated spectrum.
+ * The spectrum is taken to be linear between the grid points, so that the
+ * cumulative distribution is piecewise quadratic and can be inverted exactly.
+ * A guide table with one entry per grid interval finds the interval of a
+ * uniform number in constant time on average. Random numbers are drawn from
+ * the counter-based stream of utilities::CounterUniform, so that energy i of
+ * a seed is the same no matter which thread draws it.
+ */
+class SpectrumSampler {
+ public:
+  SpectrumSampler() {};
+  /**
+   * Constructor, builds the cumulative distribution and the guide table
+   *
+   * @param W the grid of total energies in units of the electron rest mass
+   * @param rate the decay rate at every energy of the grid
+   */
+  SpectrumSampler(Span<const double> W, Span<const double> rate);
+
+  /**
+   * Get the energy at which the cumulative distribution equals u
+   *
+   * @param u a number between 0 and 1
+   * @returns the total energy in units of the electron rest mass
+   */
+  inline double Invert(double u) const {
+    std::size_t i = guide[std::min(guide.size() - 1, (std::size_t)(u * guide.size()))];
+    while (i + 2 < W.size() && cdf[i + 1] < u) i++;
+    double r = u - cdf[i];
+    double f0 = density[i];
+    double a = slope[i];
+    double d = f0 + std::sqrt(std::max(0., f0 * f0 + 4. * a * r));
+    double t = d > 0. ? 2. * r / d : 0.;
+    return W[i] + std::min(std::max(t, 0.), W[i + 1] - W[i]);
+  };
+  /**
+   * Sample consecutive energies of a random number stream
+   *
+   * @param seed the seed of the stream
+   * @param first the position in the stream of the first energy
+   * @param energies view to be filled with total energies in units of the electron rest mass
+   */
+  void Sample(std::uint64_t seed, std::uint64_t first, Span<double> energies) const;
+  /**
+   * Get the cumulative distribution of the tabulated spectrum
+   *
+   * @param W the total energy in units of the electron rest mass
+   */
+  double Cdf(double W) const;
+  /**
+   * Compare sampled energies with a cumulative distribution using a
+   * Kolmogorov-Smirnov test. To test the sampler as a whole, including the
+   * linear interpolation of the tabulated spectrum, the distribution should
+   * be calculated independently of the table, e.g. with
+   * Generator::BuildReferenceCdf.
+   *
+   * @param energies the sampled total energies in units of the electron rest mass
+   * @param cdf the expected cumulative distribution as a function of the total energy
+   */
+  static GoodnessOfFit TestGoodnessOfFit(std::vector<double> energies,
+                                         const std::function<double(double)>& cdf);
+
+  /**
+   * Get the integral of the tabulated spectrum with the trapezoidal rule
+   */
+  inline double GetTotal() const { return total; };
+
+ private:
+  std::vector<double> W; /**< grid of total energies */
+  std::vector<double> cdf; /**< normalized cumulative distribution at the grid points */
+  std::vector<double> density; /**< normalized spectrum at the start of every interval */
+  std::vector<double> slope; /**< half the slope of the normalized spectrum in every interval */
+  std::vector<std::uint32_t> guide; /**< interval containing the quantile k/(number of intervals) */
+  double total = 0.; /**< integral of the spectrum */
+};
+
+}
+
+#endif
@@ -0,0 +1,73 @@
+#ifndef SPECTRUMSCAN
+#define SPECTRUMSCAN
+
+#include <string>
+
+#include "Span.h"
+#include "Spectrum.h"
+
+namespace bsg {
+
+/**
+ * Spectrum on a fixed grid as a function of a parameter which enters the
+ * spectrum linearly, such as b/Ac, d/Ac or M121/M101 through the C
+ * correction. The spectrum is calculated once with the parameter set to 0
+ * and once with it set to 1, after which the spectrum and its integrals for
+ * any value x follow as (1-x) times the first plus x times the second.
+ * This is exact as long as the spectrum stays positive.
+ */
+class SpectrumScan {
+ public:
+  /**
+   * Constructor
+   *
+   * @param parameter name of the scanned option
+   * @param lower the spectrum with the parameter set to 0
+   * @param upper the spectrum with the parameter set to 1, on the same grid
+   */
+  SpectrumScan(std::string parameter, Spectrum lower, Spectrum upper);
+
+  inline std::string GetParameter() const { return parameter; };
+  inline Span<const double> GetW() const { return lower.GetW(); };
+
+  /**
+   * Fill the electron and neutrino spectra for a value of the parameter
+   *
+   * @param x the value of the parameter
+   * @param electron view of the grid size to be filled with the electron spectrum
+   * @param neutrino view of the grid size to be filled with the neutrino spectrum
+   */
+  void Evaluate(double x, Span<double> electron, Span<double> neutrino) const;
+  /**
+   * Get the spectrum for a value of the parameter
+   *
+   * @param x the value of the parameter
+   */
+  Spectrum GetSpectrum(double x) const;
+  /**
+   * Integrate W^moment times the electron spectrum for a value of the
+   * parameter without assembling the spectrum
+   *
+   * @param x the value of the parameter
+   * @param moment the power of W, up to 2
+   */
+  double Integrate(double x, int moment = 0) const;
+  /**
+   * Calculate the mean total electron energy in units of its rest mass for a
+   * value of the parameter
+   *
+   * @param x the value of the parameter
+   */
+  double CalculateMeanEnergy(double x) const;
+
+ private:
+  std::string parameter; /**< name of the scanned option */
+  Spectrum lower; /**< spectrum with the parameter set to 0 */
+  Spectrum upper; /**< spectrum with the parameter set to 1 */
+  double lowerMoments[3]; /**< integrals of W^k times the electron spectrum of lower */
+  double upperMoments[3]; /**< integrals of W^k times the electron spectrum of upper */
+};
+
+}
+
+#endif
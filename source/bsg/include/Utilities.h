@@ -3,10 +3,19 @@
 
 // standard classes
 #include <iostream>
+#include <cmath>
+#include <cstdint>
 #include <stdio.h>
 #include <stdlib.h>
 #include <vector>
 #include <complex>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 #include "Constants.h"
 
@@ -167,6 +176,66 @@ class Lagrange {
   double yC[3];
 };
 
+/**
+ * Piecewise Chebyshev interpolant of a smooth function on an interval.
+ * The interval is bisected until on every piece the interpolation error is
+ * below the requested tolerance. The error is estimated from the two highest
+ * Chebyshev coefficients and verified against the function itself halfway
+ * between the interpolation nodes.
+ */
+class PiecewiseChebyshev {
+ public:
+  PiecewiseChebyshev() {};
+  /**
+   * Constructor
+   *
+   * @param f the function to interpolate
+   * @param a lower edge of the interval
+   * @param b upper edge of the interval
+   * @param tolerance the absolute interpolation error to reach
+   * @param degree the degree of the polynomial on every piece
+   * @param maxPieces the maximal number of pieces
+   */
+  PiecewiseChebyshev(std::function<double(double)> f, double a, double b,
+                     double tolerance, int degree = 12, int maxPieces = 256);
+  double GetValue(double x) const;
+  /**
+   * Evaluate the interpolant for an array of values. Pieces are looked up by
+   * walking from the previous value, which is fastest for sorted values.
+   *
+   * @param x array of n values
+   * @param y array of n interpolated values to be filled
+   * @param n number of values
+   * @param error optional array of n estimated errors of the pieces to be filled
+   */
+  void GetValues(const double* x, double* y, size_t n,
+                 double* error = nullptr) const;
+  /**
+   * Check whether x lies within the interpolated interval
+   */
+  inline bool Contains(double x) const {
+    return !pieces.empty() && x >= pieces.front().a && x <= pieces.back().b;
+  };
+  inline size_t GetNumberOfPieces() const { return pieces.size(); };
+  /**
+   * Get the largest estimated interpolation error over all pieces. This
+   * exceeds the tolerance only when the maximal number of pieces was reached
+   * or a piece could not be bisected further.
+   */
+  inline double GetErrorEstimate() const { return maxError; };
+
+ private:
+  struct Piece {
+    double a, b;
+    std::vector<double> c; /**< Chebyshev coefficients */
+    double error; /**< estimated interpolation error */
+  };
+  void Fit(const std::function<double(double)>& f, double a, double b,
+           double tolerance, int degree, int maxPieces);
+  std::vector<Piece> pieces; /**< consecutive pieces in increasing order */
+  double maxError = 0.;
+};
+
 /**
  * Perform Simpson integration
  *
@@ -187,17 +256,27 @@ inline double Simpson(double x[], double y[], int size) {
   return result;
 }
 
-inline double Simpson(std::vector<std::vector<double> > values) {
+/**
+ * Perform Simpson integration of x^moment y(x) without copying or allocating
+ *
+ * @param x array of x values
+ * @param y array of y values
+ * @param size size of the arrays
+ * @param moment the power of x multiplying y
+ */
+inline double Simpson(const double* x, const double* y, size_t size,
+                      int moment = 0) {
   double result = 0.;
-  if (values.size() > 2) {
-    for (int i = 0; i < values.size()-2; i += 2) {
-      double xN[] = {values[i][0], values[i+1][0], values[i+2][0]};
-      double yN[] = {values[i][1], values[i+1][1], values[i+2][1]};
-      double h = (xN[2] - xN[0]) / 2.;
-      Lagrange* l = new Lagrange(xN, yN);
-      result += 1. / 3. * h * (values[i][1] + 4. * l->GetValue(xN[0] + h) + values[i + 2][1]);
-      if (result != result) result = 0.;
+  for (size_t i = 0; i + 2 < size; i += 2) {
+    double xN[] = {x[i], x[i + 1], x[i + 2]};
+    double yN[] = {y[i], y[i + 1], y[i + 2]};
+    for (int j = 0; j < moment; j++) {
+      for (int k = 0; k < 3; k++) yN[k] *= xN[k];
     }
+    double h = (xN[2] - xN[0]) / 2.;
+    Lagrange l(xN, yN);
+    result += 1. / 3. * h * (yN[0] + 4. * l.GetValue(xN[0] + h) + yN[2]);
+    if (result != result) result = 0.;
   }
   return result;
 }
@@ -217,6 +296,208 @@ inline double Trapezoid(double x[], double y[], int size) {
   }
   return result;
 }
+
+/**
+ * Bounded multi-producer multi-consumer queue which does not use locks.
+ * Every cell carries a sequence number telling producers and consumers
+ * whether it is free or filled for the current turn around the ring
+ * (D. Vyukov's bounded MPMC queue).
+ */
+template <typename T>
+class LockFreeQueue {
+ public:
+  /**
+   * Constructor
+   *
+   * @param capacity the number of cells, rounded up to a power of two
+   */
+  explicit LockFreeQueue(size_t capacity) {
+    size_t size = 2;
+    while (size < capacity) size *= 2;
+    cells.reset(new Cell[size]);
+    mask = size - 1;
+    for (size_t i = 0; i < size; i++) {
+      cells[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  };
+
+  /**
+   * Add a value to the queue
+   *
+   * @returns false if the queue is full
+   */
+  bool TryPush(const T& value) {
+    size_t pos = enqueuePos.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+      cell = &cells[pos & mask];
+      size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+      if (diff == 0) {
+        if (enqueuePos.compare_exchange_weak(pos, pos + 1,
+                                             std::memory_order_relaxed))
+          break;
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = enqueuePos.load(std::memory_order_relaxed);
+      }
+    }
+    cell->data = value;
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    return true;
+  };
+
+  /**
+   * Take the oldest value from the queue
+   *
+   * @returns false if the queue is empty
+   */
+  bool TryPop(T& value) {
+    size_t pos = dequeuePos.load(std::memory_order_relaxed);
+    Cell* cell;
+    while (true) {
+      cell = &cells[pos & mask];
+      size_t sequence = cell->sequence.load(std::memory_order_acquire);
+      intptr_t diff = (intptr_t)sequence - (intptr_t)(pos + 1);
+      if (diff == 0) {
+        if (dequeuePos.compare_exchange_weak(pos, pos + 1,
+                                             std::memory_order_relaxed))
+          break;
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = dequeuePos.load(std::memory_order_relaxed);
+      }
+    }
+    value = cell->data;
+    cell->sequence.store(pos + mask + 1, std::memory_order_release);
+    return true;
+  };
+
+ private:
+  struct Cell {
+    std::atomic<size_t> sequence;
+    T data;
+  };
+  std::unique_ptr<Cell[]> cells;
+  size_t mask;
+  alignas(64) std::atomic<size_t> enqueuePos{0};
+  alignas(64) std::atomic<size_t> dequeuePos{0};
+};
+
+/**
+ * Counter-based random number: the value for a given seed and counter is a
+ * fixed hash of both, so that results do not depend on the order in which
+ * numbers are drawn or on the number of threads drawing them. The hash is the
+ * SplitMix64 generator evaluated at position counter of the stream of seed.
+ *
+ * @param seed the seed of the stream
+ * @param counter the position in the stream
+ * @returns a uniformly distributed 64-bit integer
+ */
+inline uint64_t CounterRandom(uint64_t seed, uint64_t counter) {
+  uint64_t z = seed * 0xbf58476d1ce4e5b9ULL + (counter + 1) * 0x9e3779b97f4a7c15ULL;
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+/**
+ * Counter-based uniform random number in the open interval (0, 1)
+ *
+ * @see CounterRandom
+ */
+inline double CounterUniform(uint64_t seed, uint64_t counter) {
+  return ((CounterRandom(seed, counter) >> 11) + 0.5) * 0x1.0p-53;
+}
+
+/**
+ * Counter-based standard normal random number, using the Box-Muller transform
+ * of the uniform numbers at positions 2 counter and 2 counter + 1
+ *
+ * @see CounterRandom
+ */
+inline double CounterNormal(uint64_t seed, uint64_t counter) {
+  double u1 = CounterUniform(seed, 2 * counter);
+  double u2 = CounterUniform(seed, 2 * counter + 1);
+  return std::sqrt(-2. * std::log(u1)) * std::cos(2. * M_PI * u2);
+}
+
+/**
+ * Get a GSL integration workspace with 1000 subintervals which belongs to the
+ * calling thread. It is allocated on first use and reused afterwards.
+ * An integration evaluated inside the integrand of another one must use a
+ * workspace of a larger depth, as GSL keeps its state in the workspace.
+ *
+ * @param depth the nesting depth of the integration, 0 or 1
+ */
+gsl_integration_workspace* GetIntegrationWorkspace(int depth = 0);
+
+/**
+ * Turn off the GSL error handler, which aborts by default, so that failing
+ * GSL routines return an error code instead. The handler belongs to the whole
+ * process, so it is turned off once and never restored, as restoring it in
+ * one thread would abort a routine failing in another.
+ */
+void TurnOffGSLErrorHandler();
+
+/**
+ * Get the number of worker threads to use, where 0 or less means one thread
+ * per available hardware core
+ *
+ * @param requested the requested number of threads
+ */
+inline int GetThreadCount(int requested) {
+  if (requested > 0) return requested;
+  return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/**
+ * Call f(i) for every index i in [0, n) using a number of threads.
+ * Indices are handed out in chunks from a shared counter, so that threads which
+ * finish cheap work early pick up the remaining chunks. Any exception thrown by
+ * f is rethrown in the calling thread.
+ *
+ * @param n number of indices
+ * @param nThreads number of threads, 1 runs everything in the calling thread
+ * @param chunkSize number of consecutive indices taken at a time
+ * @param f callable taking a single size_t index
+ */
+template <typename F>
+inline void ParallelFor(size_t n, int nThreads, size_t chunkSize, F f) {
+  chunkSize = std::max((size_t)1, chunkSize);
+  if (nThreads <= 1 || n <= chunkSize) {
+    for (size_t i = 0; i < n; i++) f(i);
+    return;
+  }
+  nThreads = (int)std::min((size_t)nThreads, (n + chunkSize - 1) / chunkSize);
+
+  std::atomic<size_t> next(0);
+  std::exception_ptr error;
+  std::mutex errorMutex;
+
+  auto worker = [&]() {
+    try {
+      size_t begin;
+      while ((begin = next.fetch_add(chunkSize)) < n) {
+        size_t end = std::min(n, begin + chunkSize);
+        for (size_t i = begin; i < end; i++) f(i);
+      }
+    } catch (...) {
+      std::lock_guard<std::mutex> lock(errorMutex);
+      if (!error) error = std::current_exception();
+      next = n;
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (int t = 1; t < nThreads; t++) threads.emplace_back(worker);
+  worker();
+  for (std::thread& t : threads) t.join();
+
+  if (error) std::rethrow_exception(error);
+}
 }
 
 }
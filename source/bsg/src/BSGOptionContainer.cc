@@ -123,6 +123,29 @@ bsg::BSGOptionContainer::BSGOptionContainer(int argc, char** argv) {
       "Specify the number of steps in the total spectrum")(
       "Spectrum.Neutrino,v", po::value<bool>()->default_value(true),
       "Turn off the generation of the neutrino spectrum.")(
+      "Spectrum.Threads,t", po::value<int>()->default_value(1),
+      "Specify the number of threads used to calculate the spectrum. Use 0 "
+      "for one thread per available core.")(
+      "Spectrum.RawFormat", po::value<std::string>()->default_value("text"),
+      "Set the layout of the .raw spectrum file, either text or binary. The "
+      "binary layout contains four little-endian doubles per energy: W, the "
+      "kinetic energy in keV and the electron and neutrino spectra.")(
+      "Spectrum.IntegralOnly", po::value<bool>()->default_value(false),
+      "Only calculate f, the mean energy and the higher moments of the "
+      "spectrum using adaptive integration, without sampling the spectrum.")(
+      "Spectrum.Tolerance", po::value<double>()->default_value(1e-8),
+      "Specify the relative tolerance of the adaptive integration and of the "
+      "interpolated spectrum.")(
+      "Spectrum.Interpolate", po::value<bool>()->default_value(false),
+      "Calculate the spectrum by interpolating the product of all corrections "
+      "from its values at Chebyshev nodes, up to a relative error of "
+      "Spectrum.Tolerance, instead of evaluating it at every energy. The fit "
+      "takes about 5000 evaluations, so with the default step size it is "
+      "slower than direct evaluation for endpoints below about 500 keV and "
+      "only pays off on finer grids.")(
+      "Spectrum.Moments", po::value<int>()->default_value(2),
+      "Specify the highest power of W for which the spectrum is integrated "
+      "in integral-only mode.")(
       "Spectrum.Connect", po::value<bool>()->default_value(false),
       "Turn on the connection between BSG and NME for the calculation the C_I "
       "correction, thereby using the single particle states from the latter")(
@@ -146,7 +169,34 @@ bsg::BSGOptionContainer::BSGOptionContainer(int argc, char** argv) {
       "Constants.gM", po::value<double>()->default_value(4.706),
       "Specify the weak magnetism coupling constant, gM")(
       "Constants.gP", po::value<double>()->default_value(0.),
-      "Specify the induced pseudoscalar coupling constant, gP");
+      "Specify the induced pseudoscalar coupling constant, gP")(
+      "MC.Samples", po::value<int>()->default_value(0),
+      "Specify the number of Monte Carlo samples used to propagate the "
+      "uncertainties of the parameters given with MC.Parameter. Use 0 to "
+      "turn off the propagation.")(
+      "MC.Seed", po::value<int>()->default_value(0),
+      "Specify the seed of the Monte Carlo samples.")(
+      "MC.Parameter", po::value<std::vector<std::string> >()->multitoken(),
+      "Specify the distribution of a varied parameter as "
+      "Parameter=normal:sigma or Parameter=uniform:halfwidth. Supported are "
+      "Transition.QValue, Daughter.Radius, Daughter.Beta2, "
+      "Spectrum.WeakMagnetism, Spectrum.InducedTensor, Spectrum.Lambda and "
+      "Transition.MixingRatio.")(
+      "Sampler.Events", po::value<std::size_t>()->default_value(0),
+      "Specify the number of energies to sample from the calculated "
+      "spectrum and write to the .events file. Use 0 to turn off sampling.")(
+      "Sampler.Seed", po::value<int>()->default_value(0),
+      "Specify the seed of the sampled energies.")(
+      "Sampler.Particle", po::value<std::string>()->default_value("electron"),
+      "Set the particle whose energies are sampled, either electron or "
+      "neutrino.")(
+      "Sampler.Format", po::value<std::string>()->default_value("binary"),
+      "Set the layout of the .events file, either text with one kinetic "
+      "energy in keV per line or binary with one little-endian double per "
+      "energy.")(
+      "Sampler.Test", po::value<std::size_t>()->default_value(1000000),
+      "Specify the number of sampled energies compared with the spectrum in "
+      "a Kolmogorov-Smirnov test.");
 
   std::string configName = "";
   std::string inputName = "";
@@ -156,10 +206,30 @@ bsg::BSGOptionContainer::BSGOptionContainer(int argc, char** argv) {
       "exchangedata,e",
       po::value<std::string>()->default_value("ExchangeData.dat"),
       "Set the location of the atomic exchange parameters file.")(
+      "fitcache", po::value<std::string>()->default_value(""),
+      "Set the location of the cache of Modified Gaussian charge "
+      "distribution fits, by default HOFitCache.bin next to the atomic "
+      "exchange parameters file. Use none to turn off the cache.")(
       "input,i", po::value<std::string>(&inputName),
       "Specify input file containing transition and nuclear data")(
+      "batch", po::value<std::string>(),
+      "Specify a file listing one input file per line, or a quoted wildcard "
+      "pattern of input files, to calculate all transitions in one run.")(
+      "scan", po::value<std::string>(),
+      "Scan Spectrum.WeakMagnetism, Spectrum.InducedTensor or Spectrum.Lambda "
+      "over a range of values given as Parameter=begin:end:steps, writing the "
+      "log f(t) value and mean energy of every value to the .scan file.")(
+      "serve", po::value<std::string>(),
+      "Calculate spectra on request over a local socket at the given path. "
+      "Every request is a line containing a JSON object, see the "
+      "documentation for its fields.")(
+      "jobs,j", po::value<int>()->default_value(0),
+      "Specify the number of transitions calculated concurrently in batch "
+      "mode, or of connections served concurrently in server mode. Use 0 for "
+      "one per available core.")(
       "output,o", po::value<std::string>()->default_value("output"),
-      "Specify the output file name.")(
+      "Specify the output file name, or none to discard the logs and write "
+      "no output files.")(
       "version", "Show the current version");
 
   ParseCmdLineOptions(argc, argv);
@@ -0,0 +1,281 @@
+#include "CorrectionPlan.h"
+#include "CorrectionProfile.h"
+#include "Utilities.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+/**
+ * Multiply result with the correction f evaluated at every energy in W
+ */
+static void ApplyCorrection(const std::function<double(double)>& f,
+                            const bsg::BatchFunction& fBatch, const double* W,
+                            double* result, double* factor, std::size_t n) {
+  if (fBatch) {
+    fBatch(W, factor, n);
+    for (std::size_t i = 0; i < n; i++) result[i] *= factor[i];
+  } else {
+    for (std::size_t i = 0; i < n; i++) result[i] *= f(W[i]);
+  }
+}
+
+void bsg::CorrectionPlan::Add(CorrectionType type,
+                              std::function<double(double)> f) {
+  corrections.push_back({type, DependsOnlyOnW(type), f, f, nullptr, nullptr});
+}
+
+void bsg::CorrectionPlan::Add(CorrectionType type,
+                              std::function<double(double)> f,
+                              BatchFunction fBatch) {
+  corrections.push_back({type, DependsOnlyOnW(type), f, f, fBatch, fBatch});
+}
+
+void bsg::CorrectionPlan::Add(CorrectionType type,
+                              std::function<double(double)> electron,
+                              std::function<double(double)> neutrino) {
+  corrections.push_back({type, false, electron, neutrino, nullptr, nullptr});
+}
+
+bool bsg::CorrectionPlan::Replace(CorrectionType type,
+                                  std::function<double(double)> f,
+                                  BatchFunction fBatch) {
+  for (Correction& c : corrections) {
+    if (c.type == type) {
+      c = {type, DependsOnlyOnW(type), f, f, fBatch, fBatch};
+      return true;
+    }
+  }
+  return false;
+}
+
+bool bsg::CorrectionPlan::Replace(CorrectionType type,
+                                  std::function<double(double)> f) {
+  for (Correction& c : corrections) {
+    if (c.type == type) {
+      c = {type, DependsOnlyOnW(type), f, f, nullptr, nullptr};
+      return true;
+    }
+  }
+  return false;
+}
+
+bool bsg::CorrectionPlan::Replace(CorrectionType type,
+                                  std::function<double(double)> electron,
+                                  std::function<double(double)> neutrino) {
+  for (Correction& c : corrections) {
+    if (c.type == type) {
+      c = {type, false, electron, neutrino, nullptr, nullptr};
+      return true;
+    }
+  }
+  return false;
+}
+
+bool bsg::CorrectionPlan::DependsOnlyOnW(CorrectionType type) {
+  switch (type) {
+    case FERMI_FUNCTION:
+    case L0_CORRECTION:
+    case U_CORRECTION:
+    case ATOMIC_SCREENING:
+    case ATOMIC_EXCHANGE:
+      return true;
+    default:
+      return false;
+  }
+}
+
+std::string bsg::CorrectionPlan::GetName(CorrectionType type) {
+  switch (type) {
+    case PHASE_SPACE: return "Phasespace";
+    case FERMI_FUNCTION: return "Fermi";
+    case C_CORRECTION: return "C";
+    case RELATIVISTIC_CORRECTION: return "Relativistic";
+    case DEFORMATION_CORRECTION: return "ESDeformation";
+    case L0_CORRECTION: return "ESFiniteSize";
+    case U_CORRECTION: return "U";
+    case Q_CORRECTION: return "CoulombRecoil";
+    case RADIATIVE_CORRECTION: return "Radiative";
+    case RECOIL_CORRECTION: return "Recoil";
+    case ATOMIC_SCREENING: return "Screening";
+    case ATOMIC_EXCHANGE: return "Exchange";
+    case ATOMIC_MISMATCH: return "AtomicMismatch";
+  }
+  return "Unknown";
+}
+
+bool bsg::CorrectionPlan::IsEnabled(CorrectionType type) const {
+  for (const Correction& c : corrections) {
+    if (c.type == type) return true;
+  }
+  return false;
+}
+
+std::tuple<double, double> bsg::CorrectionPlan::Evaluate(double W) const {
+  double result = 1;
+  double neutrinoResult = 1;
+
+  double Wv = W0 - W + 1;
+
+  for (const Correction& c : corrections) {
+    BSG_PROFILE_START(start);
+    result *= c.electron(W);
+    neutrinoResult *= c.neutrino(Wv);
+    BSG_PROFILE_STOP(profile, c.type, start, 2);
+  }
+
+  result = std::max(0., result);
+  neutrinoResult = std::max(0., neutrinoResult);
+  return std::make_tuple(result, neutrinoResult);
+}
+
+void bsg::CorrectionPlan::Evaluate(const double* W, double* electron,
+                                   double* neutrino, std::size_t n) const {
+  // scratch space on the stack, as this is called for every block of energies
+  double Wv[blockSize], factor[blockSize];
+  for (std::size_t begin = 0; begin < n; begin += blockSize) {
+    std::size_t m = std::min(blockSize, n - begin);
+    const double* We = W + begin;
+    double* e = electron + begin;
+    double* v = neutrino + begin;
+    for (std::size_t i = 0; i < m; i++) {
+      Wv[i] = W0 - We[i] + 1;
+      e[i] = 1;
+      v[i] = 1;
+    }
+
+    for (const Correction& c : corrections) {
+      BSG_PROFILE_START(start);
+      ApplyCorrection(c.electron, c.electronBatch, We, e, factor, m);
+      ApplyCorrection(c.neutrino, c.neutrinoBatch, Wv, v, factor, m);
+      BSG_PROFILE_STOP(profile, c.type, start, 2 * m);
+    }
+
+    for (std::size_t i = 0; i < m; i++) {
+      e[i] = std::max(0., e[i]);
+      v[i] = std::max(0., v[i]);
+    }
+  }
+}
+
+void bsg::CorrectionPlan::Apply(const double* W, double* result,
+                                double* factor, std::size_t n,
+                                bool neutrinoSide, bool shared) const {
+  for (const Correction& c : corrections) {
+    if (c.shared != shared) continue;
+    BSG_PROFILE_START(start);
+    if (neutrinoSide) {
+      ApplyCorrection(c.neutrino, c.neutrinoBatch, W, result, factor, n);
+    } else {
+      ApplyCorrection(c.electron, c.electronBatch, W, result, factor, n);
+    }
+    BSG_PROFILE_STOP(profile, c.type, start, n);
+  }
+}
+
+std::size_t bsg::CorrectionPlan::Evaluate(const std::vector<double>& W,
+                                          std::vector<double>& electron,
+                                          std::vector<double>& neutrino,
+                                          int nThreads) const {
+  std::size_t n = W.size();
+
+  // on a symmetric grid the neutrino energy of point i is the electron
+  // energy of point n - 1 - i
+  bool symmetric = true;
+  for (std::size_t i = 0; i < n && symmetric; i++) {
+    double mirror = W[n - 1 - i];
+    symmetric = std::abs(W0 - W[i] + 1 - mirror) <= 1e-12 * std::abs(mirror);
+  }
+
+  // on a uniform grid W0 - W[i] + 1 can only coincide with W[j] when
+  // W0 + 1 - 2 W[0] is close to a whole number of steps, so that otherwise
+  // the two sets of energies are simply concatenated without sorting
+  bool disjoint = false;
+  if (!symmetric && n > 1) {
+    double step = (W[n - 1] - W[0]) / (n - 1);
+    double scale = std::max(std::abs(W[0]), std::abs(W[n - 1]));
+    bool uniform = step > 0.;
+    for (std::size_t i = 1; i < n && uniform; i++) {
+      uniform = std::abs(W[i] - (W[0] + i * step)) <= 1e-12 * scale;
+    }
+    if (uniform) {
+      double offset = W0 + 1 - 2 * W[0];
+      disjoint = std::abs(offset - std::round(offset / step) * step) > 1e-9 * scale;
+    }
+  }
+
+  std::vector<double> mergedW;
+  std::vector<std::size_t> unionIndex(2 * n);
+  std::size_t matched = 0;
+  if (symmetric) {
+    for (std::size_t i = 0; i < n; i++) {
+      unionIndex[i] = i;
+      unionIndex[n + i] = n - 1 - i;
+    }
+    matched = n;
+  } else if (disjoint) {
+    mergedW.resize(2 * n);
+    for (std::size_t i = 0; i < n; i++) {
+      mergedW[i] = W[i];
+      mergedW[n + i] = W0 - W[i] + 1;
+      unionIndex[i] = i;
+      unionIndex[n + i] = n + i;
+    }
+  } else {
+    /**
+     * Sort the electron and neutrino energies together and merge the ones
+     * which coincide, remembering where every original energy ended up
+     */
+    std::vector<std::pair<double, std::size_t> > points(2 * n);
+    for (std::size_t i = 0; i < n; i++) {
+      points[i] = std::make_pair(W[i], i);
+      points[n + i] = std::make_pair(W0 - W[i] + 1, n + i);
+    }
+    std::sort(points.begin(), points.end());
+
+    std::vector<bool> hasElectron;
+    for (const auto& point : points) {
+      bool isElectron = point.second < n;
+      if (mergedW.empty() ||
+          std::abs(point.first - mergedW.back()) > 1e-12 * std::abs(point.first) ||
+          (isElectron && hasElectron.back())) {
+        mergedW.push_back(point.first);
+        hasElectron.push_back(isElectron);
+      } else {
+        if (isElectron) hasElectron.back() = true;
+        matched++;
+      }
+      unionIndex[point.second] = mergedW.size() - 1;
+    }
+  }
+  const std::vector<double>& unionW = symmetric ? W : mergedW;
+
+  // the shared corrections on the union of all energies
+  std::vector<double> shared(unionW.size(), 1.);
+  std::size_t nBlocks = (unionW.size() + blockSize - 1) / blockSize;
+  utilities::ParallelFor(nBlocks, nThreads, 1, [&](std::size_t b) {
+    std::size_t begin = b * blockSize;
+    std::size_t m = std::min(blockSize, unionW.size() - begin);
+    double factor[blockSize];
+    Apply(&unionW[begin], &shared[begin], factor, m, false, true);
+  });
+
+  // the remaining corrections at the electron and neutrino energies
+  electron.assign(n, 1.);
+  neutrino.assign(n, 1.);
+  nBlocks = (n + blockSize - 1) / blockSize;
+  utilities::ParallelFor(nBlocks, nThreads, 1, [&](std::size_t b) {
+    std::size_t begin = b * blockSize;
+    std::size_t m = std::min(blockSize, n - begin);
+    double Wv[blockSize], factor[blockSize];
+    for (std::size_t i = 0; i < m; i++) Wv[i] = W0 - W[begin + i] + 1;
+    Apply(&W[begin], &electron[begin], factor, m, false, false);
+    Apply(Wv, &neutrino[begin], factor, m, true, false);
+    for (std::size_t i = begin; i < begin + m; i++) {
+      electron[i] = std::max(0., electron[i] * shared[unionIndex[i]]);
+      neutrino[i] = std::max(0., neutrino[i] * shared[unionIndex[n + i]]);
+    }
+  });
+
+  return matched;
+}
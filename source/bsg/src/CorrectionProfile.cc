@@ -0,0 +1,65 @@
+#include "CorrectionProfile.h"
+
+#include <cstdio>
+
+void bsg::CorrectionProfile::Reset() {
+  for (CorrectionTiming& t : timings) {
+    t.calls = 0;
+    t.points = 0;
+    t.cycles = 0;
+    t.minCycles = UINT64_MAX;
+    t.maxCycles = 0;
+  }
+  startTime = std::chrono::steady_clock::now();
+  startCycles = ReadCycleCounter();
+}
+
+double bsg::CorrectionProfile::GetNsPerCycle() const {
+  std::uint64_t cycles = ReadCycleCounter() - startCycles;
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - startTime).count();
+  return cycles > 0 ? ns / cycles : 1.;
+}
+
+std::string bsg::CorrectionProfile::FormatTable() const {
+  double nsPerCycle = GetNsPerCycle();
+  double total = 0.;
+  for (const CorrectionTiming& t : timings) total += t.cycles;
+
+  char line[256];
+  std::snprintf(line, sizeof(line), "%-16s %12s %12s %12s %12s %12s %12s %7s\n", "Correction", "calls", "points",
+                "total [ms]", "ns/point", "min [ns]", "max [ns]", "share");
+  std::string result = line;
+  for (int type = 0; type < nCorrectionTypes; type++) {
+    const CorrectionTiming& t = timings[type];
+    if (t.calls == 0) continue;
+    std::snprintf(line, sizeof(line), "%-16s %12llu %12llu %12.3f %12.2f %12.1f %12.1f %6.1f%%\n",
+                  CorrectionPlan::GetName((CorrectionType)type).c_str(), (unsigned long long)t.calls,
+                  (unsigned long long)t.points, t.cycles * nsPerCycle * 1e-6,
+                  t.points > 0 ? t.cycles * nsPerCycle / t.points : 0., t.minCycles * nsPerCycle,
+                  t.maxCycles * nsPerCycle, total > 0. ? 100. * t.cycles / total : 0.);
+    result += line;
+  }
+  return result;
+}
+
+std::string bsg::CorrectionProfile::FormatJson() const {
+  double nsPerCycle = GetNsPerCycle();
+  char line[512];
+  std::snprintf(line, sizeof(line), "{\n  \"nsPerCycle\": %.6g,\n  \"corrections\": [", nsPerCycle);
+  std::string result = line;
+  bool first = true;
+  for (int type = 0; type < nCorrectionTypes; type++) {
+    const CorrectionTiming& t = timings[type];
+    if (t.calls == 0) continue;
+    std::snprintf(line, sizeof(line),
+                  "%s\n    {\"name\": \"%s\", \"calls\": %llu, \"points\": %llu, \"totalNs\": %.6g, "
+                  "\"nsPerPoint\": %.6g, \"minNs\": %.6g, \"maxNs\": %.6g}",
+                  first ? "" : ",", CorrectionPlan::GetName((CorrectionType)type).c_str(),
+                  (unsigned long long)t.calls, (unsigned long long)t.points, t.cycles * nsPerCycle,
+                  t.points > 0 ? t.cycles * nsPerCycle / t.points : 0., t.minCycles * nsPerCycle,
+                  t.maxCycles * nsPerCycle);
+    result += line;
+    first = false;
+  }
+  return result + "\n  ]\n}\n";
+}
@@ -0,0 +1,120 @@
+#include "FitCache.h"
+#include "Utilities.h"
+
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * Header at the start of the cache file
+ */
+struct FitCacheHeader {
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t entrySize;
+  std::uint64_t capacity;
+  std::uint64_t reserved;
+};
+
+static const char fitCacheMagic[8] = {'B', 'S', 'G', 'F', 'I', 'T', 'C', '\0'};
+
+/**
+ * Advisory lock on a file descriptor, released when going out of scope
+ */
+class FileLock {
+ public:
+  FileLock(int fd, int operation) : fd(fd) { flock(fd, operation); };
+  ~FileLock() { flock(fd, LOCK_UN); };
+
+ private:
+  int fd;
+};
+
+static std::uint64_t GetFitCacheKey(int fitter, int Z, double rms) {
+  std::uint64_t bits;
+  std::memcpy(&bits, &rms, sizeof(bits));
+  std::uint64_t key =
+      bsg::utilities::CounterRandom(((std::uint64_t)(std::uint32_t)fitter << 32) | (std::uint32_t)Z, bits);
+  return key == 0 ? 1 : key;
+}
+
+bsg::FitCache::FitCache(std::string filename) {
+  fd = open(filename.c_str(), O_RDWR | O_CREAT, 0666);
+  if (fd < 0) return;
+
+  std::size_t size = sizeof(FitCacheHeader) + capacity * sizeof(FitCacheEntry);
+  {
+    FileLock lock(fd, LOCK_EX);
+    FitCacheHeader header;
+    struct stat st;
+    bool valid = fstat(fd, &st) == 0 && (std::size_t)st.st_size == size &&
+                 pread(fd, &header, sizeof(header), 0) == sizeof(header) &&
+                 std::memcmp(header.magic, fitCacheMagic, sizeof(fitCacheMagic)) == 0 &&
+                 header.version == version && header.entrySize == sizeof(FitCacheEntry) &&
+                 header.capacity == capacity;
+    if (!valid) {
+      std::memset(&header, 0, sizeof(header));
+      std::memcpy(header.magic, fitCacheMagic, sizeof(fitCacheMagic));
+      header.version = version;
+      header.entrySize = sizeof(FitCacheEntry);
+      header.capacity = capacity;
+      if (ftruncate(fd, 0) != 0 || ftruncate(fd, size) != 0 ||
+          pwrite(fd, &header, sizeof(header), 0) != sizeof(header)) {
+        close(fd);
+        fd = -1;
+        return;
+      }
+    }
+  }
+
+  map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (map == MAP_FAILED) {
+    map = nullptr;
+    close(fd);
+    fd = -1;
+    return;
+  }
+  mapSize = size;
+  entries = reinterpret_cast<FitCacheEntry*>(static_cast<char*>(map) + sizeof(FitCacheHeader));
+}
+
+bsg::FitCache::~FitCache() {
+  if (map) munmap(map, mapSize);
+  if (fd >= 0) close(fd);
+}
+
+bsg::FitCacheEntry* bsg::FitCache::Find(std::uint64_t key, int fitter, int Z, double rms) const {
+  for (std::size_t i = 0; i < capacity; i++) {
+    FitCacheEntry* entry = &entries[(key + i) % capacity];
+    if (entry->key == 0 || (entry->key == key && entry->fitter == fitter && entry->Z == Z && entry->rms == rms)) {
+      return entry;
+    }
+  }
+  return nullptr;
+}
+
+bool bsg::FitCache::Lookup(int fitter, int Z, double rms, double& value) const {
+  if (!IsOpen()) return false;
+  FileLock lock(fd, LOCK_SH);
+  FitCacheEntry* entry = Find(GetFitCacheKey(fitter, Z, rms), fitter, Z, rms);
+  if (!entry || entry->key == 0) return false;
+  value = entry->value;
+  return true;
+}
+
+void bsg::FitCache::Store(int fitter, int Z, double rms, double value) {
+  if (!IsOpen()) return;
+  FileLock lock(fd, LOCK_EX);
+  std::uint64_t key = GetFitCacheKey(fitter, Z, rms);
+  FitCacheEntry* entry = Find(key, fitter, Z, rms);
+  if (!entry) return;
+  entry->fitter = fitter;
+  entry->Z = Z;
+  entry->rms = rms;
+  entry->value = value;
+  entry->key = key;
+}
@@ -1,20 +1,30 @@
 #include "Generator.h"
 #include "spdlog/sinks/basic_file_sink.h"
+#include "spdlog/sinks/null_sink.h"
 #include "spdlog/sinks/stdout_color_sinks.h"
 
-#include "BSGOptionContainer.h"
 #include "ChargeDistributions.h"
 #include "Constants.h"
+#include "FitCache.h"
 #include "Utilities.h"
 #include "SpectralFunctions.h"
 
+#include <algorithm>
 #include <iostream>
 #include <stdio.h>
 #include <vector>
 #include <cmath>
 #include <chrono>
+#include <array>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <fstream>
+#include <cstring>
 
 #include "boost/algorithm/string.hpp"
+#include "spdlog/fmt/fmt.h"
 
 #include "BSGConfig.h"
 
@@ -25,9 +35,8 @@ namespace NS = nme::NuclearStructure;
 using std::cout;
 using std::endl;
 
-void ShowBSGInfo() {
+void ShowBSGInfo(std::shared_ptr<spdlog::logger> logger) {
   std::string author = "L. Hayen (leendert.hayen@kuleuven.be)";
-  auto logger = spdlog::get("BSG_results_file");
   logger->info("{:*>60}", "");
   logger->info("{:^60}", "BSG v" + std::string(BSG_VERSION));
   logger->info("{:^60}", "Last update: " + std::string(BSG_LAST_UPDATE));
@@ -35,35 +44,54 @@ void ShowBSGInfo() {
   logger->info("{:*>60}\n", "");
 }
 
-bsg::Generator::Generator() {
+bsg::Generator::Generator() : Generator(GeneratorConfig::FromOptions()) {}
+
+bsg::Generator::Generator(const GeneratorConfig& config) : config(config) {
+  // integration failures are reported by the status codes they return
+  utilities::TurnOffGSLErrorHandler();
   InitializeLoggers();
   InitializeConstants();
   InitializeShapeParameters();
-  InitializeL0Constants();
-  if (GetBSGOpt(bool, Spectrum.Exchange)) {
+  if (config.Get<bool>("Spectrum.Exchange")) {
     LoadExchangeParameters();
   }
-  InitializeNSMInfo();
+  InitializeCorrectionPlan();
   debugFileLogger->debug("Leaving Generator constructor");
 }
 
 bsg::Generator::~Generator() { delete nsm; }
 
+/**
+ * Create the sink of a file logger, discarding all messages when no files are
+ * written
+ */
+static spdlog::sink_ptr MakeFileSink(const std::string& filename, bool writeFiles) {
+  if (!writeFiles) return std::make_shared<spdlog::sinks::null_sink_mt>();
+  return std::make_shared<spdlog::sinks::basic_file_sink_mt>(filename);
+}
+
 void bsg::Generator::InitializeLoggers() {
-  SetOutputName(GetBSGOpt(std::string, output));
+  SetOutputName(config.Get<std::string>("output"));
+  writeFiles = outputName != "none";
 
   /**
    * Remove result & log files if they already exist
    */
-  if (std::ifstream(outputName + ".log")) std::remove((outputName + ".log").c_str());
-  if (std::ifstream(outputName + ".raw")) std::remove((outputName + ".raw").c_str());
-  if (std::ifstream(outputName + ".txt")) std::remove((outputName + ".txt").c_str());
-
-  debugFileLogger = spdlog::get("debug_file");
-  if (!debugFileLogger) {
-    debugFileLogger = spdlog::basic_logger_mt("debug_file", outputName + ".log");
-    debugFileLogger->set_level(spdlog::level::debug);
+  if (writeFiles) {
+    if (std::ifstream(outputName + ".log")) std::remove((outputName + ".log").c_str());
+    if (std::ifstream(outputName + ".raw")) std::remove((outputName + ".raw").c_str());
+    if (std::ifstream(outputName + ".txt")) std::remove((outputName + ".txt").c_str());
   }
+
+  /**
+   * Every Generator writes to its own files. The file loggers are not
+   * registered by name, so that Generators of several transitions can exist
+   * at the same time, and are handed to the nuclear structure manager.
+   * With output none they are turned off, so that messages are not even
+   * formatted, and no raw spectrum writer is started.
+   */
+  debugFileLogger = std::make_shared<spdlog::logger>("debug_file", MakeFileSink(outputName + ".log", writeFiles));
+  debugFileLogger->set_level(writeFiles ? spdlog::level::debug : spdlog::level::off);
   debugFileLogger->debug("Debugging logger created");
   consoleLogger = spdlog::get("console");
   if (!consoleLogger) {
@@ -72,49 +100,47 @@ void bsg::Generator::InitializeLoggers() {
     consoleLogger->set_level(spdlog::level::warn);
   }
   debugFileLogger->debug("Console logger created");
-  rawSpectrumLogger = spdlog::get("BSG_raw");
-  if (!rawSpectrumLogger) {
-    rawSpectrumLogger = spdlog::basic_logger_mt("BSG_raw", outputName + ".raw");
-    rawSpectrumLogger->set_pattern("%v");
-    rawSpectrumLogger->set_level(spdlog::level::info);
-  }
-  debugFileLogger->debug("Raw spectrum logger created");
-  resultsFileLogger = spdlog::get("BSG_results_file");
-  if (!resultsFileLogger) {
-    resultsFileLogger = spdlog::basic_logger_mt("BSG_results_file", outputName + ".txt");
-    resultsFileLogger->set_pattern("%v");
-    resultsFileLogger->set_level(spdlog::level::info);
+  if (writeFiles) {
+    std::string rawFormat = config.Get<std::string>("Spectrum.RawFormat");
+    rawSpectrumWriter.reset(new RawSpectrumWriter(
+        outputName + ".raw", boost::iequals(rawFormat, "binary")
+                                 ? RawSpectrumWriter::BINARY
+                                 : RawSpectrumWriter::TEXT));
+    debugFileLogger->debug("Raw spectrum writer created with {} format", rawFormat);
   }
+  resultsFileLogger = std::make_shared<spdlog::logger>("BSG_results_file", MakeFileSink(outputName + ".txt", writeFiles));
+  resultsFileLogger->set_pattern("%v");
+  resultsFileLogger->set_level(writeFiles ? spdlog::level::info : spdlog::level::off);
   debugFileLogger->debug("Results file logger created");
 }
 
 void bsg::Generator::InitializeConstants() {
   debugFileLogger->debug("Entered initialize constants");
 
-  Z = GetBSGOpt(int, Daughter.Z);
-  A = GetBSGOpt(int, Daughter.A);
+  Z = config.Get<int>("Daughter.Z");
+  A = config.Get<int>("Daughter.A");
 
-  R = GetBSGOpt(double, Daughter.Radius) * 1e-15 / NATURAL_LENGTH * std::sqrt(5. / 3.);
+  R = config.Get<double>("Daughter.Radius") * 1e-15 / NATURAL_LENGTH * std::sqrt(5. / 3.);
   if (R == 0.0) {
     debugFileLogger->debug("Radius not found. Using standard formula.");
     R = 1.2 * std::pow(A, 1. / 3.) * 1e-15 / NATURAL_LENGTH;
   }
-  motherBeta2 = GetBSGOpt(double, Mother.Beta2);
-  daughterBeta2 = GetBSGOpt(double, Daughter.Beta2);
-  motherSpinParity = GetBSGOpt(int, Mother.SpinParity);
-  daughterSpinParity = GetBSGOpt(int, Daughter.SpinParity);
+  motherBeta2 = config.Get<double>("Mother.Beta2");
+  daughterBeta2 = config.Get<double>("Daughter.Beta2");
+  motherSpinParity = config.Get<int>("Mother.SpinParity");
+  daughterSpinParity = config.Get<int>("Daughter.SpinParity");
 
-  motherExcitationEn = GetBSGOpt(double, Mother.ExcitationEnergy);
-  daughterExcitationEn = GetBSGOpt(double, Daughter.ExcitationEnergy);
+  motherExcitationEn = config.Get<double>("Mother.ExcitationEnergy");
+  daughterExcitationEn = config.Get<double>("Daughter.ExcitationEnergy");
 
-  gA = GetBSGOpt(double, Constants.gA);
-  gP = GetBSGOpt(double, Constants.gP);
-  gM = GetBSGOpt(double, Constants.gM);
+  gA = config.Get<double>("Constants.gA");
+  gP = config.Get<double>("Constants.gP");
+  gM = config.Get<double>("Constants.gM");
 
   debugFileLogger->debug("gP: {}", gP);
 
-  std::string process = GetBSGOpt(std::string, Transition.Process);
-  std::string type = GetBSGOpt(std::string, Transition.Type);
+  std::string process = config.Get<std::string>("Transition.Process");
+  std::string type = config.Get<std::string>("Transition.Type");
 
   if (boost::iequals(process, "B+")) {
     betaType = BETA_PLUS;
@@ -129,97 +155,182 @@ void bsg::Generator::InitializeConstants() {
     decayType = GAMOW_TELLER;
   } else {
     decayType = MIXED;
-    mixingRatio = GetBSGOpt(double, Transition.MixingRatio);
+    mixingRatio = config.Get<double>("Transition.MixingRatio");
   }
 
-  if (A != GetBSGOpt(int, Mother.A)) {
+  if (A != config.Get<int>("Mother.A")) {
     consoleLogger->error("Mother and daughter mass numbers are not the same.");
   }
-  if (Z != GetBSGOpt(int, Mother.Z)+betaType) {
+  if (Z != config.Get<int>("Mother.Z")+betaType) {
     consoleLogger->error("Mother and daughter cannot be obtained through {} process", process);
   }
 
-  QValue = GetBSGOpt(double, Transition.QValue);
+  QValue = config.Get<double>("Transition.QValue");
+
+  atomicEnergyDeficit = config.Get<double>("Transition.AtomicEnergyDeficit");
 
-  atomicEnergyDeficit = GetBSGOpt(double, Transition.AtomicEnergyDeficit);
+  W0 = CalculateEndpoint(QValue);
+  debugFileLogger->debug("Leaving InitializeConstants");
+}
 
+double bsg::Generator::CalculateEndpoint(double QValue) const {
+  double W0;
   if (betaType == BETA_MINUS) {
     W0 = (QValue - atomicEnergyDeficit + motherExcitationEn - daughterExcitationEn) / ELECTRON_MASS_KEV + 1.;
   } else {
     W0 = (QValue - atomicEnergyDeficit + motherExcitationEn - daughterExcitationEn) / ELECTRON_MASS_KEV - 1.;
   }
-  W0 = W0 - (W0 * W0 - 1) / 2. / A / (NUCLEON_MASS_KEV / ELECTRON_MASS_KEV);
-  debugFileLogger->debug("Leaving InitializeConstants");
+  return W0 - (W0 * W0 - 1) / 2. / A / (NUCLEON_MASS_KEV / ELECTRON_MASS_KEV);
 }
 
-void bsg::Generator::InitializeShapeParameters() {
-  debugFileLogger->debug("Entered InitializeShapeParameters");
-  if (!BSGOptExists(Spectrum.ModGaussFit)) {
-    hoFit = CD::FitHODist(Z, R * std::sqrt(3. / 5.));
-  } else {
-    hoFit = GetBSGOpt(double, Spectrum.ModGaussFit);
+double bsg::Generator::GetHOFit(int Z, double rms) {
+  std::string cacheName = config.Get<std::string>("fitcache");
+  if (cacheName == "none") return CD::FitHODist(Z, rms);
+  if (cacheName.empty()) {
+    std::string exParamFile = config.Get<std::string>("exchangedata");
+    std::size_t slash = exParamFile.find_last_of('/');
+    cacheName = (slash == std::string::npos ? "" : exParamFile.substr(0, slash + 1)) + "HOFitCache.bin";
+  }
+
+  FitCache cache(cacheName);
+  double value;
+  if (cache.Lookup(CD::hoFitter, Z, rms, value)) {
+    debugFileLogger->debug("Found Modified Gaussian fit for Z = {} and rms = {} in {}", Z, rms, cacheName);
+    return value;
   }
-  debugFileLogger->debug("hoFit: {}", hoFit);
+  if (!cache.IsOpen()) {
+    debugFileLogger->warn("Cannot open fit cache {}", cacheName);
+  }
+  value = CD::FitHODist(Z, rms);
+  cache.Store(CD::hoFitter, Z, rms, value);
+  return value;
+}
+
+void bsg::Generator::RequireHOFit() {
+  std::call_once(hoFitFlag, [this]() {
+    if (!config.Exists("Spectrum.ModGaussFit")) {
+      hoFit = GetHOFit(Z, R * std::sqrt(3. / 5.));
+    } else {
+      hoFit = config.Get<double>("Spectrum.ModGaussFit");
+    }
+    debugFileLogger->debug("hoFit: {}", hoFit);
+  });
+}
+
+void bsg::Generator::RequireL0Constants() {
+  std::call_once(l0Flag, [this]() { InitializeL0Constants(); });
+}
 
-  ESShape = GetBSGOpt(std::string, Spectrum.ESShape);
-  NSShape = GetBSGOpt(std::string, Spectrum.NSShape);
+void bsg::Generator::RequireMatrixElements() {
+  std::call_once(matrixElementsFlag, [this]() { InitializeNSMInfo(); });
+}
+
+NS::NuclearStructureManager* bsg::Generator::GetNuclearStructureManager() {
+  if (!nsm) {
+    debugFileLogger->debug("Constructing the nuclear structure manager");
+    if (writeFiles && std::ifstream(outputName + ".nme")) std::remove((outputName + ".nme").c_str());
+    auto nmeResultsLogger = std::make_shared<spdlog::logger>("nme_results_file",
+        MakeFileSink(outputName + ".nme", writeFiles));
+    nmeResultsLogger->set_pattern("%v");
+    nmeResultsLogger->set_level(writeFiles ? spdlog::level::info : spdlog::level::off);
+    nsm = new NS::NuclearStructureManager(config.GetNMEOptions(), consoleLogger, debugFileLogger,
+                                          nmeResultsLogger);
+  }
+  return nsm;
+}
+
+void bsg::Generator::InitializeShapeParameters() {
+  debugFileLogger->debug("Entered InitializeShapeParameters");
+  ESShape = config.Get<std::string>("Spectrum.ESShape");
+  NSShape = config.Get<std::string>("Spectrum.NSShape");
 
   vOld.resize(3);
   vNew.resize(3);
 
   if (ESShape == "Modified_Gaussian") {
     debugFileLogger->debug("Found Modified_Gaussian shape");
+    RequireHOFit();
     vOld[0] = 3./2.;
     vOld[1] = -1./2.;
     vNew[0] = std::sqrt(5./2.)*4.*(1.+hoFit)*std::sqrt(2.+5.*hoFit)/std::sqrt(M_PI)*std::pow(2.+3.*hoFit, 3./2.);
     vNew[1] = -4./3./(3.*hoFit+2)/std::sqrt(M_PI)*std::pow(5.*(2.+5.*hoFit)/2./(2.+3.*hoFit), 3./2.);
     vNew[2] = (2.-7.*hoFit)/5./(3.*hoFit+2)/std::sqrt(M_PI)*std::pow(5.*(2.+5.*hoFit)/2./(2.+3.*hoFit), 5./3.);
   } else {
-    if (BSGOptExists(Spectrum.vold) && BSGOptExists(Spectrum.vnew)) {
+    if (config.Exists("Spectrum.vold") && config.Exists("Spectrum.vnew")) {
       debugFileLogger->debug("Found v and v'");
-      vOld = GetBSGOpt(std::vector<double>, Spectrum.vold);
-      vNew = GetBSGOpt(std::vector<double>, Spectrum.vnew);
-    } else if (BSGOptExists(vold) || BSGOptExists(vnew)) {
+      vOld = config.Get<std::vector<double>>("Spectrum.vold");
+      vNew = config.Get<std::vector<double>>("Spectrum.vnew");
+    } else if (config.Exists("vold") || config.Exists("vnew")) {
       consoleLogger->error("ERROR: Both old and new potential expansions must be given.");
     }
   }
   debugFileLogger->debug("Leaving InitializeShapeParameters");
 }
 
-void bsg::Generator::LoadExchangeParameters() {
-  debugFileLogger->debug("Entered LoadExchangeParameters");
-  std::string exParamFile = GetBSGOpt(std::string, exchangedata);
-  std::ifstream paramStream(exParamFile.c_str());
-  std::string line;
+/**
+ * Read the rows of an atomic exchange parameters file, each consisting of the
+ * proton number followed by nine fit coefficients. Files are read only once
+ * per process and shared between Generators.
+ *
+ * @param exParamFile path to the exchange parameters file
+ * @returns pointer to the rows, or nullptr when the file cannot be opened
+ */
+static const std::vector<std::array<double, 10> >* GetExchangeTable(
+    const std::string& exParamFile) {
+  static std::mutex mutex;
+  static std::map<std::string, std::vector<std::array<double, 10> > > tables;
 
-  if (paramStream.is_open()) {
-    while (getline(paramStream, line)) {
-      double z;
-      double a, b, c, d, e, f, g, h, i;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = tables.find(exParamFile);
+  if (it == tables.end()) {
+    std::ifstream paramStream(exParamFile.c_str());
+    if (!paramStream.is_open()) return nullptr;
 
+    std::vector<std::array<double, 10> > rows;
+    std::string line;
+    while (getline(paramStream, line)) {
+      std::array<double, 10> row;
       std::istringstream iss(line);
-      iss >> z >> a >> b >> c >> d >> e >> f >> g >> h >> i;
-
-      if (z == Z - betaType) {
-        exPars[0] = a;
-        exPars[1] = b;
-        exPars[2] = c;
-        exPars[3] = d;
-        exPars[4] = e;
-        exPars[5] = f;
-        exPars[6] = g;
-        exPars[7] = h;
-        exPars[8] = i;
-      }
+      for (double& x : row) iss >> x;
+      if (!iss.fail()) rows.push_back(row);
     }
-  } else {
+    it = tables.insert(std::make_pair(exParamFile, rows)).first;
+  }
+  return &it->second;
+}
+
+void bsg::Generator::LoadExchangeParameters() {
+  debugFileLogger->debug("Entered LoadExchangeParameters");
+  std::string exParamFile = config.Get<std::string>("exchangedata");
+  if (!GetExchangeTable(exParamFile)) {
     consoleLogger->error("ERROR: Can't find Exchange parameters file at {}.", exParamFile);
+  } else {
+    GetExchangeParameters(exParamFile, Z - betaType, exPars);
   }
   debugFileLogger->debug("Leaving LoadExchangeParameters");
 }
 
+bool bsg::Generator::GetExchangeParameters(const std::string& exParamFile, int Z, double exPars[9]) {
+  const std::vector<std::array<double, 10> >* table = GetExchangeTable(exParamFile);
+  if (!table) return false;
+
+  bool found = false;
+  for (const std::array<double, 10>& row : *table) {
+    if (row[0] == Z) {
+      std::copy(row.begin() + 1, row.end(), exPars);
+      found = true;
+    }
+  }
+  return found;
+}
+
 void bsg::Generator::InitializeL0Constants() {
   debugFileLogger->debug("Entering InitializeL0Constants");
+  CalculateL0Coefficients(Z, aPos, aNeg);
+  debugFileLogger->debug("Leaving InitializeL0Constants");
+}
+
+void bsg::Generator::CalculateL0Coefficients(double Z, double aPos[7], double aNeg[7]) {
   //double b[7][6];
   double bNeg[7][6];
   bNeg[0][0] = 0.115;
@@ -317,16 +428,13 @@ void bsg::Generator::InitializeL0Constants() {
       aPos[i] += bPos[i][j] * std::pow(ALPHA * Z, j + 1);
     }
   }
-  debugFileLogger->debug("Leaving InitializeL0Constants");
 }
 
 void bsg::Generator::InitializeNSMInfo() {
   debugFileLogger->debug("Entering InitializeNSMInfo");
-  nsm = new NS::NuclearStructureManager();
-
-  if (BSGOptExists(connect)) {
+  if (config.Exists("connect")) {
     int dKi, dKf;
-    nsm->GetESPStates(spsi, spsf, dKi, dKf);
+    GetNuclearStructureManager()->GetESPStates(spsi, spsf, dKi, dKf);
   }
 
   GetMatrixElements();
@@ -335,26 +443,26 @@ void bsg::Generator::InitializeNSMInfo() {
 void bsg::Generator::GetMatrixElements() {
   debugFileLogger->info("Calculating matrix elements");
   double M101 = 1.0;
-  if (!BSGOptExists(Spectrum.Lambda)) {
-    M101 = nsm->CalculateReducedMatrixElement(false, 1, 0, 1);
-    double M121 = nsm->CalculateReducedMatrixElement(false, 1, 2, 1);
+  if (!config.Exists("Spectrum.Lambda")) {
+    M101 = GetNuclearStructureManager()->CalculateReducedMatrixElement(false, 1, 0, 1);
+    double M121 = GetNuclearStructureManager()->CalculateReducedMatrixElement(false, 1, 2, 1);
     ratioM121 = M121 / M101;
   } else {
-    ratioM121 = GetBSGOpt(double, Spectrum.Lambda);
+    ratioM121 = config.Get<double>("Spectrum.Lambda");
   }
 
   bAc = dAc = 0;
-  if (!BSGOptExists(Spectrum.WeakMagnetism)) {
+  if (!config.Exists("Spectrum.WeakMagnetism")) {
     debugFileLogger->info("Calculating Weak Magnetism");
-    bAc = nsm->CalculateWeakMagnetism();
+    bAc = GetNuclearStructureManager()->CalculateWeakMagnetism();
   } else {
-    bAc = GetBSGOpt(double, Spectrum.WeakMagnetism);
+    bAc = config.Get<double>("Spectrum.WeakMagnetism");
   }
-  if (!BSGOptExists(Spectrum.InducedTensor)) {
+  if (!config.Exists("Spectrum.InducedTensor")) {
     debugFileLogger->info("Calculating Induced Tensor");
-    dAc = nsm->CalculateInducedTensor();
+    dAc = GetNuclearStructureManager()->CalculateInducedTensor();
   } else {
-    dAc = GetBSGOpt(double, Spectrum.InducedTensor);
+    dAc = config.Get<double>("Spectrum.InducedTensor");
   }
 
   if (std::isnan(bAc)) {
@@ -386,157 +494,945 @@ void bsg::Generator::GetMatrixElements() {
   fc1 = gA * M101;
   fb = bAc * A * fc1;
   fd = dAc * A * fc1;
+  matrixElementsCalculated = true;
+}
+
+void bsg::Generator::InitializeCorrectionPlan() {
+  debugFileLogger->debug("Entering InitializeCorrectionPlan");
+  /**
+   * The form factors are only needed by the C correction and by the
+   * calculations which vary them, and are calculated here so that the
+   * nuclear structure calculation happens during construction.
+   */
+  if (config.Get<bool>("Spectrum.C") || config.Exists("scan") ||
+      (config.Exists("MC.Samples") && config.Get<int>("MC.Samples") > 0)) {
+    RequireMatrixElements();
+  }
+  correctionPlan = BuildCorrectionPlan(GetTransitionParameters());
+#ifdef BSG_PROFILE_CORRECTIONS
+  correctionPlan.SetProfile(&correctionProfile);
+#endif
+  debugFileLogger->debug("Correction plan contains {} corrections", correctionPlan.GetCorrections().size());
+  debugFileLogger->debug("Leaving InitializeCorrectionPlan");
+}
+
+bsg::TransitionParameters bsg::Generator::GetTransitionParameters() const {
+  return {W0, R, daughterBeta2, fb, fd, ratioM121, mixingRatio};
+}
+
+bsg::CorrectionPlan bsg::Generator::BuildCorrectionPlan(
+    const TransitionParameters& p) {
+  CorrectionPlan plan(p.W0);
+  BindCorrections(plan, p);
+  return plan;
+}
+
+/**
+ * Replace a correction in a plan, or add it when the plan does not contain it
+ */
+template <typename... Functions>
+static void BindCorrection(bsg::CorrectionPlan& plan, bsg::CorrectionType type,
+                           Functions... f) {
+  if (!plan.Replace(type, f...)) plan.Add(type, f...);
+}
+
+void bsg::Generator::BindCorrections(CorrectionPlan& plan,
+                                     const TransitionParameters& p,
+                                     const TransitionParameters* previous) {
+  /**
+   * All constants are captured by value, so that the plan stays valid and
+   * independent of the Generator when it is copied
+   */
+  const double W0 = p.W0;
+  const double R = p.R;
+  const bool all = previous == nullptr;
+  const bool newW0 = all || W0 != previous->W0;
+  const bool newR = all || R != previous->R;
+  const bool newBeta2 = all || p.daughterBeta2 != previous->daughterBeta2;
+  const bool newFormFactors = all || p.fb != previous->fb ||
+                              p.fd != previous->fd ||
+                              p.ratioM121 != previous->ratioM121;
+  const bool newMixing = all || p.mixingRatio != previous->mixingRatio;
+  plan.SetEndpoint(W0);
+
+  if (config.Get<bool>("Spectrum.Phasespace") && newW0) {
+    int ms = motherSpinParity, ds = daughterSpinParity;
+    BindCorrection(plan, PHASE_SPACE,
+        [W0, ms, ds](double W) {
+          return SF::PhaseSpace(W, W0, ms, ds);
+        },
+        [W0, ms, ds](const double* W, double* result, std::size_t n) {
+          SF::PhaseSpace(W, result, n, W0, ms, ds);
+        });
+  }
+  if (config.Get<bool>("Spectrum.Fermi") && newR) {
+    SF::FermiFunctionConstants c = SF::PrepareFermiFunction(Z, R, betaType);
+    BindCorrection(plan, FERMI_FUNCTION, [c](double W) {
+      return SF::FermiFunction(W, c);
+    });
+  }
+  if (config.Get<bool>("Spectrum.C") && (newW0 || newR || newFormFactors)) {
+    SetCCorrection(plan, p);
+  }
+  if (config.Get<bool>("Spectrum.Relativistic") && (newW0 || newR)) {
+    SF::RelativisticCorrectionConstants c =
+        SF::PrepareRelativisticCorrection(W0, Z, A, R, betaType, decayType);
+    BindCorrection(plan, RELATIVISTIC_CORRECTION,
+        [c](double W) { return SF::RelativisticCorrection(W, c); },
+        [c](const double* W, double* result, std::size_t n) {
+          SF::RelativisticCorrection(W, result, n, c);
+        });
+  }
+  if (config.Get<bool>("Spectrum.ESDeformation") || config.Get<bool>("Spectrum.ESFiniteSize")) {
+    RequireL0Constants();
+  }
+  if (config.Get<bool>("Spectrum.ESDeformation") && (newW0 || newR || newBeta2)) {
+    SF::DeformationCorrectionConstants c = SF::PrepareDeformationCorrection(
+        W0, Z, R, p.daughterBeta2, betaType, aPos, aNeg);
+    if (all) {
+      debugFileLogger->debug("Deformation correction tabulated in {} pieces, "
+                             "estimated interpolation error {}",
+                             c.table.GetNumberOfPieces(),
+                             c.table.GetErrorEstimate());
+    }
+    BindCorrection(plan, DEFORMATION_CORRECTION, [c](double W) {
+      return SF::DeformationCorrection(W, c);
+    });
+  }
+  if (config.Get<bool>("Spectrum.ESFiniteSize") && newR) {
+    SF::L0CorrectionConstants c =
+        SF::PrepareL0Correction(Z, R, betaType, aPos, aNeg);
+    BindCorrection(plan, L0_CORRECTION,
+        [c](double W) { return SF::L0Correction(W, c); },
+        [c](const double* W, double* result, std::size_t n) {
+          SF::L0Correction(W, result, n, c);
+        });
+  }
+  if (config.Get<bool>("Spectrum.U") && newR) {
+    SF::UCorrectionConstants c =
+        SF::PrepareUCorrection(Z, R, betaType, ESShape, vOld, vNew);
+    BindCorrection(plan, U_CORRECTION,
+        [c](double W) { return SF::UCorrection(W, c); },
+        [c](const double* W, double* result, std::size_t n) {
+          SF::UCorrection(W, result, n, c);
+        });
+  }
+  if (config.Get<bool>("Spectrum.CoulombRecoil") && (newW0 || newMixing)) {
+    SF::QCorrectionConstants c = SF::PrepareQCorrection(
+        W0, Z, A, betaType, decayType, p.mixingRatio);
+    BindCorrection(plan, Q_CORRECTION,
+        [c](double W) { return SF::QCorrection(W, c); },
+        [c](const double* W, double* result, std::size_t n) {
+          SF::QCorrection(W, result, n, c);
+        });
+  }
+  if (config.Get<bool>("Spectrum.Radiative") && (newW0 || newR)) {
+    SF::RadiativeCorrectionConstants c =
+        SF::PrepareRadiativeCorrection(W0, Z, R, betaType, gA, gM);
+    BindCorrection(plan, RADIATIVE_CORRECTION,
+                   [c](double W) { return SF::RadiativeCorrection(W, c); },
+                   [](double Wv) {
+                     return SF::NeutrinoRadiativeCorrection(Wv);
+                   });
+  }
+  if (config.Get<bool>("Spectrum.Recoil") && (newW0 || newMixing)) {
+    SF::RecoilCorrectionConstants c =
+        SF::PrepareRecoilCorrection(W0, A, decayType, p.mixingRatio);
+    BindCorrection(plan, RECOIL_CORRECTION,
+        [c](double W) { return SF::RecoilCorrection(W, c); },
+        [c](const double* W, double* result, std::size_t n) {
+          SF::RecoilCorrection(W, result, n, c);
+        });
+  }
+  if (config.Get<bool>("Spectrum.Screening") && all) {
+    SF::AtomicScreeningCorrectionConstants c =
+        SF::PrepareAtomicScreeningCorrection(Z, betaType);
+    plan.Add(ATOMIC_SCREENING, [c](double W) {
+      return SF::AtomicScreeningCorrection(W, c);
+    });
+  }
+  if (config.Get<bool>("Spectrum.Exchange") && betaType == BETA_MINUS && all) {
+    std::array<double, 9> ex;
+    std::copy(exPars, exPars + 9, ex.begin());
+    plan.Add(ATOMIC_EXCHANGE,
+        [ex](double W) {
+          return SF::AtomicExchangeCorrection(W, ex.data());
+        },
+        [ex](const double* W, double* result, std::size_t n) {
+          SF::AtomicExchangeCorrection(W, result, n, ex.data());
+        });
+  }
+  if (config.Get<bool>("Spectrum.AtomicMismatch") && atomicEnergyDeficit == 0. && newW0) {
+    SF::AtomicMismatchCorrectionConstants c =
+        SF::PrepareAtomicMismatchCorrection(W0, Z, A, betaType);
+    BindCorrection(plan, ATOMIC_MISMATCH, [c](double W) {
+      return SF::AtomicMismatchCorrection(W, c);
+    });
+  }
+}
+
+bsg::CorrectionPlan bsg::Generator::BuildReferenceCorrectionPlan() {
+  /**
+   * Every correction calls the full-argument spectral function, which
+   * evaluates the original expression at each energy. Arrays and vectors
+   * passed by non-const pointer or reference are copies owned by the closure.
+   */
+  TransitionParameters p = GetTransitionParameters();
+  const double W0 = p.W0;
+  const double R = p.R;
+  const int z = Z, a = A, type = betaType, decay = decayType;
+  CorrectionPlan plan(W0);
+
+  if (config.Get<bool>("Spectrum.Phasespace")) {
+    int ms = motherSpinParity, ds = daughterSpinParity;
+    plan.Add(PHASE_SPACE, [W0, ms, ds](double W) {
+      return SF::PhaseSpace(W, W0, ms, ds);
+    });
+  }
+  if (config.Get<bool>("Spectrum.Fermi")) {
+    plan.Add(FERMI_FUNCTION, [z, R, type](double W) {
+      return SF::FermiFunction(W, z, R, type);
+    });
+  }
+  if (config.Get<bool>("Spectrum.C")) {
+    RequireMatrixElements();
+    if (boost::iequals(NSShape, "ModGauss")) RequireHOFit();
+    const bool addCI = config.Get<bool>("Spectrum.Isovector");
+    if (config.Exists("connect")) {
+      plan.Add(C_CORRECTION, [=, gA = gA, gP = gP, fc1 = fc1, shape = NSShape,
+                              ho = hoFit, si = spsi, sf = spsf](double W) mutable {
+        return SF::CCorrection(W, W0, z, a, R, type, decay, gA, gP, fc1, p.fb,
+                               p.fd, p.ratioM121, addCI, shape, ho, si, sf);
+      });
+    } else {
+      plan.Add(C_CORRECTION, [=, gA = gA, gP = gP, fc1 = fc1, shape = NSShape,
+                              ho = hoFit](double W) {
+        return SF::CCorrection(W, W0, z, a, R, type, decay, gA, gP, fc1, p.fb,
+                               p.fd, p.ratioM121, addCI, shape, ho);
+      });
+    }
+  }
+  if (config.Get<bool>("Spectrum.Relativistic")) {
+    plan.Add(RELATIVISTIC_CORRECTION, [=](double W) {
+      return SF::RelativisticCorrection(W, W0, z, a, R, type, decay);
+    });
+  }
+  if (config.Get<bool>("Spectrum.ESDeformation") || config.Get<bool>("Spectrum.ESFiniteSize")) {
+    RequireL0Constants();
+  }
+  std::array<double, 7> pos, neg;
+  std::copy(aPos, aPos + 7, pos.begin());
+  std::copy(aNeg, aNeg + 7, neg.begin());
+  if (config.Get<bool>("Spectrum.ESDeformation")) {
+    const double beta2 = p.daughterBeta2;
+    plan.Add(DEFORMATION_CORRECTION, [=](double W) mutable {
+      return SF::DeformationCorrection(W, W0, z, R, beta2, type, pos.data(),
+                                       neg.data());
+    });
+  }
+  if (config.Get<bool>("Spectrum.ESFiniteSize")) {
+    plan.Add(L0_CORRECTION, [=](double W) mutable {
+      return SF::L0Correction(W, z, R, type, pos.data(), neg.data());
+    });
+  }
+  if (config.Get<bool>("Spectrum.U")) {
+    plan.Add(U_CORRECTION, [=, shape = ESShape, v = vOld,
+                            vp = vNew](double W) mutable {
+      return SF::UCorrection(W, z, R, type, shape, v, vp);
+    });
+  }
+  if (config.Get<bool>("Spectrum.CoulombRecoil")) {
+    const double mixing = p.mixingRatio;
+    plan.Add(Q_CORRECTION, [=](double W) {
+      return SF::QCorrection(W, W0, z, a, type, decay, mixing);
+    });
+  }
+  if (config.Get<bool>("Spectrum.Radiative")) {
+    plan.Add(RADIATIVE_CORRECTION,
+             [=, gA = gA, gM = gM](double W) {
+               return SF::RadiativeCorrection(W, W0, z, R, type, gA, gM);
+             },
+             [](double Wv) { return SF::NeutrinoRadiativeCorrection(Wv); });
+  }
+  if (config.Get<bool>("Spectrum.Recoil")) {
+    const double mixing = p.mixingRatio;
+    plan.Add(RECOIL_CORRECTION, [=](double W) {
+      return SF::RecoilCorrection(W, W0, a, decay, mixing);
+    });
+  }
+  if (config.Get<bool>("Spectrum.Screening")) {
+    plan.Add(ATOMIC_SCREENING, [z, type](double W) {
+      return SF::AtomicScreeningCorrection(W, z, type);
+    });
+  }
+  if (config.Get<bool>("Spectrum.Exchange") && betaType == BETA_MINUS) {
+    std::array<double, 9> ex;
+    std::copy(exPars, exPars + 9, ex.begin());
+    plan.Add(ATOMIC_EXCHANGE, [ex](double W) {
+      return SF::AtomicExchangeCorrection(W, ex.data());
+    });
+  }
+  if (config.Get<bool>("Spectrum.AtomicMismatch") && atomicEnergyDeficit == 0.) {
+    plan.Add(ATOMIC_MISMATCH, [=](double W) {
+      return SF::AtomicMismatchCorrection(W, W0, z, a, type);
+    });
+  }
+  return plan;
+}
+
+void bsg::Generator::SetCCorrection(CorrectionPlan& plan,
+                                    const TransitionParameters& p) {
+  RequireMatrixElements();
+  if (boost::iequals(NSShape, "ModGauss")) RequireHOFit();
+  SF::CCorrectionConstants c =
+      SF::PrepareCCorrection(p.W0, Z, A, p.R, betaType, decayType, gA, gP, fc1,
+                             p.fb, p.fd, p.ratioM121, NSShape, hoFit);
+  SF::CICorrectionConstants ci;
+  if (config.Get<bool>("Spectrum.Isovector")) {
+    ci = config.Exists("connect")
+             ? SF::PrepareCICorrection(p.W0, Z, p.R, betaType, spsi, spsf)
+             : SF::PrepareCICorrection(p.W0, Z, A, p.R, betaType);
+  }
+  auto f = [c, ci](double W) { return SF::CCorrection(W, c, ci); };
+  auto fBatch = [c, ci](const double* W, double* result, std::size_t n) {
+    SF::CCorrection(W, result, n, c, ci);
+  };
+  if (!plan.Replace(C_CORRECTION, f, fBatch)) {
+    plan.Add(C_CORRECTION, f, fBatch);
+  }
 }
 
 std::tuple<double, double> bsg::Generator::CalculateDecayRate(double W) {
-  // auto start = std::chrono::steady_clock::now();
-  double result = 1;
-  double neutrinoResult = 1;
-
-  double Wv = W0 - W + 1;
-
-  if (GetBSGOpt(bool, Spectrum.Phasespace)) {
-    result *= SF::PhaseSpace(W, W0, motherSpinParity, daughterSpinParity);
-    neutrinoResult *=
-        SF::PhaseSpace(Wv, W0, motherSpinParity, daughterSpinParity);
-  }
-  // auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
-  // std::cout << "PS microseconds since start: " << elapsed.count() << "\n";
-  if (GetBSGOpt(bool, Spectrum.Fermi)) {
-    result *= SF::FermiFunction(W, Z, R, betaType);
-    neutrinoResult *= SF::FermiFunction(Wv, Z, R, betaType);
-  }
-  // elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
-  // std::cout << "F microseconds since start: " << elapsed.count() << "\n";
-  if (GetBSGOpt(bool, Spectrum.C)) {
-    if (BSGOptExists(connect)) {
-      result *= SF::CCorrection(W, W0, Z, A, R, betaType, decayType, gA,
-                                gP, fc1, fb, fd, ratioM121, GetBSGOpt(bool, Spectrum.Isovector), NSShape, hoFit, spsi, spsf);
-      neutrinoResult *=
-          SF::CCorrection(Wv, W0, Z, A, R, betaType, decayType, gA, gP,
-                          fc1, fb, fd, ratioM121, GetBSGOpt(bool, Spectrum.Isovector), NSShape, hoFit, spsi, spsf);
+  auto result = correctionPlan.Evaluate(W);
+  if (rawSpectrumWriter) rawSpectrumWriter->Push(W, std::get<0>(result), std::get<1>(result));
+  return result;
+}
+
+void bsg::Generator::Evaluate(Span<const double> W, Span<double> electron,
+                              Span<double> neutrino) const {
+  if (electron.size() != W.size() || neutrino.size() != W.size()) {
+    throw std::invalid_argument("Evaluate requires views of equal length");
+  }
+  correctionPlan.Evaluate(W.data(), electron.data(), neutrino.data(), W.size());
+}
+
+const bsg::Spectrum& bsg::Generator::CalculateSpectrum() {
+  debugFileLogger->info("Calculating spectrum");
+#ifdef BSG_PROFILE_CORRECTIONS
+  correctionProfile.Reset();
+#endif
+  std::vector<double> grid = BuildGrid();
+
+  /**
+   * Every point is independent, but the cost per point varies strongly
+   * (e.g. the deformation integral), so blocks of points are distributed
+   * dynamically. Each block is evaluated one correction at a time using the
+   * batch kernels, and the corrections depending only on W are shared
+   * between the electron and the mirrored neutrino energies. Results are
+   * stored by index to preserve the ordering.
+   */
+  int nThreads = utilities::GetThreadCount(config.Get<int>("Spectrum.Threads"));
+  debugFileLogger->info("Using {} thread(s) for {} points", nThreads, grid.size());
+
+  std::vector<double> electron, neutrino;
+  if (config.Get<bool>("Spectrum.Interpolate") && !grid.empty()) {
+    auto range = std::minmax_element(grid.begin(), grid.end());
+    SpectrumInterpolant interpolant = BuildSpectrumInterpolant(*range.first, *range.second, nThreads);
+    size_t direct = interpolant.Evaluate(grid, electron, neutrino, nThreads);
+    debugFileLogger->debug("Evaluated {} of {} energies directly", direct, grid.size());
+  } else {
+    size_t merged = correctionPlan.Evaluate(grid, electron, neutrino, nThreads);
+    debugFileLogger->debug("Shared {} of {} electron and neutrino energies", merged, 2 * grid.size());
+  }
+
+  if (rawSpectrumWriter) {
+    for (size_t i = 0; i < grid.size(); i++) {
+      rawSpectrumWriter->Push(grid[i], electron[i], neutrino[i]);
+    }
+  }
+  spectrum = Spectrum(std::move(grid), std::move(electron), std::move(neutrino));
+#ifdef BSG_PROFILE_CORRECTIONS
+  WriteCorrectionProfile();
+#endif
+  if (rawSpectrumWriter) rawSpectrumWriter->Flush();
+  PrepareOutputFile();
+  return spectrum;
+}
+
+#ifdef BSG_PROFILE_CORRECTIONS
+void bsg::Generator::WriteCorrectionProfile() {
+  debugFileLogger->info("Time spent per correction:\n{}", correctionProfile.FormatTable());
+  if (!writeFiles) return;
+  std::ofstream timingFile(outputName + ".timing.json");
+  if (!timingFile) {
+    debugFileLogger->warn("Cannot open {}.timing.json", outputName);
+    return;
+  }
+  timingFile << correctionProfile.FormatJson();
+  debugFileLogger->debug("Correction timings written to {}.timing.json", outputName);
+}
+#endif
+
+bsg::SpectrumInterpolant bsg::Generator::BuildSpectrumInterpolant(double beginW, double endW, int nThreads) {
+  double tolerance = config.Get<double>("Spectrum.Tolerance");
+  SpectrumInterpolant interpolant(correctionPlan, beginW, endW, tolerance, nThreads);
+  debugFileLogger->debug("Spectrum interpolated in {} pieces from {} evaluations", interpolant.GetNumberOfPieces(),
+                         interpolant.GetEvaluations());
+  if (!interpolant.IsValid()) {
+    debugFileLogger->debug("Relative error of {} not reached everywhere, evaluating those energies directly",
+                           tolerance);
+  }
+  return interpolant;
+}
+
+std::vector<double> bsg::Generator::BuildGrid() {
+  double beginW, endW;
+  std::tie(beginW, endW) = GetEnergyRange();
+  return BuildGrid(beginW, endW);
+}
+
+std::vector<double> bsg::Generator::BuildGrid(double beginW, double endW) {
+  double stepW = config.Get<double>("Spectrum.StepSize") / ELECTRON_MASS_KEV;
+  if (config.Exists("Spectrum.Steps")) {
+    stepW = (endW-beginW)/config.Get<int>("Spectrum.Steps");
+  }
+
+  // every point is calculated from its index, so that rounding errors do not
+  // accumulate and a grid ending at W0 stays symmetric. The slack keeps the
+  // last point when the range is a whole number of steps.
+  std::vector<double> grid;
+  if (!(stepW > 0.) || endW < beginW) return grid;
+  std::size_t nSteps = (std::size_t)std::floor((endW - beginW) / stepW + 1e-9);
+  grid.reserve(nSteps + 1);
+  for (std::size_t i = 0; i <= nSteps; i++) {
+    grid.push_back(beginW + i * stepW);
+  }
+  return grid;
+}
+
+bsg::SpectrumScan bsg::Generator::PrepareScan(std::string parameter) {
+  if (parameter != "Spectrum.WeakMagnetism" && parameter != "Spectrum.InducedTensor" &&
+      parameter != "Spectrum.Lambda") {
+    throw std::invalid_argument("Cannot scan " + parameter + ", only Spectrum.WeakMagnetism, "
+                                "Spectrum.InducedTensor and Spectrum.Lambda enter the spectrum linearly");
+  }
+  if (!correctionPlan.IsEnabled(C_CORRECTION)) {
+    consoleLogger->warn("The C correction is turned off, so {} does not change the spectrum", parameter);
+  }
+  RequireMatrixElements();
+
+  std::vector<double> grid = BuildGrid();
+  int nThreads = utilities::GetThreadCount(config.Get<int>("Spectrum.Threads"));
+
+  /**
+   * The form factors only enter the nuclear-sensitive part of the C
+   * correction, and do so linearly, so that the spectrum with the parameter
+   * set to 0 and to 1 determines it for every other value
+   */
+  Spectrum spectra[2];
+  for (int x = 0; x < 2; x++) {
+    TransitionParameters p = GetTransitionParameters();
+    if (parameter == "Spectrum.WeakMagnetism") {
+      p.fb = x * A * fc1;
+    } else if (parameter == "Spectrum.InducedTensor") {
+      p.fd = x * A * fc1;
     } else {
-      result *= SF::CCorrection(W, W0, Z, A, R, betaType, decayType, gA,
-                                gP, fc1, fb, fd, ratioM121, GetBSGOpt(bool, Spectrum.Isovector), NSShape, hoFit);
-      neutrinoResult *=
-          SF::CCorrection(Wv, W0, Z, A, R, betaType, decayType, gA, gP,
-                          fc1, fb, fd, ratioM121, GetBSGOpt(bool, Spectrum.Isovector), NSShape, hoFit);
+      p.ratioM121 = x;
+    }
+    CorrectionPlan plan = correctionPlan;
+    if (plan.IsEnabled(C_CORRECTION)) {
+      SetCCorrection(plan, p);
+    }
+    std::vector<double> electron, neutrino;
+    plan.Evaluate(grid, electron, neutrino, nThreads);
+    spectra[x] = Spectrum(grid, std::move(electron), std::move(neutrino));
+  }
+  return SpectrumScan(parameter, std::move(spectra[0]), std::move(spectra[1]));
+}
+
+void bsg::Generator::CalculateScan(std::string scan) {
+  debugFileLogger->info("Calculating scan {}", scan);
+  std::vector<std::string> parts;
+  boost::split(parts, scan, boost::is_any_of("=:"));
+  if (parts.size() != 4) {
+    consoleLogger->error("Scan {} is not of the form Parameter=begin:end:steps", scan);
+    return;
+  }
+
+  double begin, end;
+  int steps;
+  try {
+    begin = std::stod(parts[1]);
+    end = std::stod(parts[2]);
+    steps = std::stoi(parts[3]);
+  } catch (std::exception& e) {
+    consoleLogger->error("Scan {} is not of the form Parameter=begin:end:steps", scan);
+    return;
+  }
+  if (steps < 1) {
+    consoleLogger->error("Scan {} requires at least one step", scan);
+    return;
+  }
+
+  std::unique_ptr<SpectrumScan> spectrumScan;
+  try {
+    spectrumScan.reset(new SpectrumScan(PrepareScan(parts[0])));
+  } catch (std::invalid_argument& e) {
+    consoleLogger->error("{}", e.what());
+    return;
+  }
+
+  double halflife = config.Exists("Transition.PartialHalflife") ? config.Get<double>("Transition.PartialHalflife") : 1.;
+  std::ofstream scanStream((outputName + ".scan").c_str());
+  scanStream << fmt::format("{:<16}\t{:<16}\t{:<16}\n", parts[0], "log f(t)", "<E> [keV]");
+  for (int i = 0; i < steps; i++) {
+    double x = steps == 1 ? begin : begin + (end - begin) * i / (steps - 1);
+    scanStream << fmt::format("{:<16.8g}\t{:<16.10f}\t{:<16.10f}\n", x,
+                              std::log10(spectrumScan->Integrate(x) * halflife),
+                              (spectrumScan->CalculateMeanEnergy(x) - 1.) * ELECTRON_MASS_KEV);
+  }
+  debugFileLogger->info("Scan written to {}.scan", outputName);
+}
+
+/**
+ * Parse a distribution of the form Parameter=normal:sigma or
+ * Parameter=uniform:halfwidth
+ */
+static bool ParseParameterDistribution(std::string description,
+                                       bsg::ParameterDistribution& distribution) {
+  std::vector<std::string> parts;
+  boost::split(parts, description, boost::is_any_of("=:"));
+  if (parts.size() != 3) return false;
+  distribution.name = parts[0];
+  if (boost::iequals(parts[1], "normal")) {
+    distribution.shape = bsg::ParameterDistribution::NORMAL;
+  } else if (boost::iequals(parts[1], "uniform")) {
+    distribution.shape = bsg::ParameterDistribution::UNIFORM;
+  } else {
+    return false;
+  }
+  try {
+    distribution.width = std::stod(parts[2]);
+  } catch (std::exception& e) {
+    return false;
+  }
+  return true;
+}
+
+bsg::TransitionParameters bsg::Generator::SampleTransitionParameters(
+    const std::vector<ParameterDistribution>& distributions, uint64_t seed,
+    std::size_t sample, std::vector<double>& deviations) const {
+  TransitionParameters p = GetTransitionParameters();
+  deviations.resize(distributions.size());
+  for (std::size_t k = 0; k < distributions.size(); k++) {
+    const ParameterDistribution& d = distributions[k];
+    uint64_t counter = sample * distributions.size() + k;
+    double x = d.shape == ParameterDistribution::NORMAL
+                   ? d.width * utilities::CounterNormal(seed, counter)
+                   : d.width * (2. * utilities::CounterUniform(seed, counter) - 1.);
+    deviations[k] = x;
+
+    if (d.name == "Transition.QValue") {
+      p.W0 = CalculateEndpoint(QValue + x);
+    } else if (d.name == "Daughter.Radius") {
+      p.R += x * 1e-15 / NATURAL_LENGTH * std::sqrt(5. / 3.);
+    } else if (d.name == "Daughter.Beta2") {
+      p.daughterBeta2 += x;
+    } else if (d.name == "Spectrum.WeakMagnetism") {
+      p.fb += x * A * fc1;
+    } else if (d.name == "Spectrum.InducedTensor") {
+      p.fd += x * A * fc1;
+    } else if (d.name == "Spectrum.Lambda") {
+      p.ratioM121 += x;
+    } else if (d.name == "Transition.MixingRatio") {
+      p.mixingRatio += x;
     }
   }
-  // elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
-  // std::cout << "C microseconds since start: " << elapsed.count() << "\n";
-  if (GetBSGOpt(bool, Spectrum.Relativistic)) {
-    result *= SF::RelativisticCorrection(W, W0, Z, A, R, betaType, decayType);
-    neutrinoResult *=
-        SF::RelativisticCorrection(Wv, W0, Z, A, R, betaType, decayType);
-  }
-  // elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
-  // std::cout << "Rel microseconds since start: " << elapsed.count() << "\n";
-  if (GetBSGOpt(bool, Spectrum.ESDeformation)) {
-    result *=
-        SF::DeformationCorrection(W, W0, Z, R, daughterBeta2, betaType, aPos, aNeg);
-    neutrinoResult *=
-        SF::DeformationCorrection(Wv, W0, Z, R, daughterBeta2, betaType, aPos, aNeg);
-  }
-  // elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
-  // std::cout << "ESD microseconds since start: " << elapsed.count() << "\n";
-  if (GetBSGOpt(bool, Spectrum.ESFiniteSize)) {
-    result *= SF::L0Correction(W, Z, R, betaType, aPos, aNeg);
-    neutrinoResult *= SF::L0Correction(Wv, Z, R, betaType, aPos, aNeg);
-  }
-  // elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
-  // std::cout << "ESF microseconds since start: " << elapsed.count() << "\n";
-  if (GetBSGOpt(bool, Spectrum.U)) {
-    result *= SF::UCorrection(W, Z, R, betaType, ESShape, vOld, vNew);
-    neutrinoResult *= SF::UCorrection(Wv, Z, R, betaType, ESShape, vOld, vNew);
-  }
-  // elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
-  // std::cout << "U microseconds since start: " << elapsed.count() << "\n";
-  if (GetBSGOpt(bool, Spectrum.CoulombRecoil)) {
-    result *= SF::QCorrection(W, W0, Z, A, betaType, decayType, mixingRatio);
-    neutrinoResult *=
-        SF::QCorrection(Wv, W0, Z, A, betaType, decayType, mixingRatio);
-  }
-  // elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
-  // std::cout << "CR microseconds since start: " << elapsed.count() << "\n";
-  if (GetBSGOpt(bool, Spectrum.Radiative)) {
-    result *= SF::RadiativeCorrection(W, W0, Z, R, betaType, gA, gM);
-    neutrinoResult *= SF::NeutrinoRadiativeCorrection(Wv);
-  }
-  // elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
-  // std::cout << "Rad microseconds since start: " << elapsed.count() << "\n";
-  if (GetBSGOpt(bool, Spectrum.Recoil)) {
-    result *= SF::RecoilCorrection(W, W0, A, decayType, mixingRatio);
-    neutrinoResult *= SF::RecoilCorrection(Wv, W0, A, decayType, mixingRatio);
-  }
-  // elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
-  // std::cout << "Rec microseconds since start: " << elapsed.count() << "\n";
-  if (GetBSGOpt(bool, Spectrum.Screening)) {
-    result *= SF::AtomicScreeningCorrection(W, Z, betaType);
-    neutrinoResult *= SF::AtomicScreeningCorrection(Wv, Z, betaType);
-  }
-  // elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
-  // std::cout << "S microseconds since start: " << elapsed.count() << "\n";
-  if (GetBSGOpt(bool, Spectrum.Exchange)) {
-    if (betaType == BETA_MINUS) {
-      result *= SF::AtomicExchangeCorrection(W, exPars);
-      neutrinoResult *= SF::AtomicExchangeCorrection(Wv, exPars);
+  return p;
+}
+
+void bsg::Generator::CalculateUncertainties() {
+  debugFileLogger->info("Calculating uncertainties");
+  RequireMatrixElements();
+  const char* supported[] = {"Transition.QValue", "Daughter.Radius", "Daughter.Beta2",
+                             "Spectrum.WeakMagnetism", "Spectrum.InducedTensor",
+                             "Spectrum.Lambda", "Transition.MixingRatio"};
+  std::vector<ParameterDistribution> distributions;
+  if (config.Exists("MC.Parameter")) {
+    for (const std::string& description : config.Get<std::vector<std::string> >("MC.Parameter")) {
+      ParameterDistribution d;
+      if (!ParseParameterDistribution(description, d)) {
+        consoleLogger->error("MC parameter {} is not of the form Parameter=normal:sigma or Parameter=uniform:halfwidth", description);
+        return;
+      }
+      if (std::find(std::begin(supported), std::end(supported), d.name) == std::end(supported)) {
+        consoleLogger->error("MC parameter {} cannot be varied, use one of {}", d.name, boost::join(std::vector<std::string>(std::begin(supported), std::end(supported)), ", "));
+        return;
+      }
+      distributions.push_back(d);
     }
   }
-  // elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
-  // std::cout << "Ex microseconds since start: " << elapsed.count() << "\n";
-  if (GetBSGOpt(bool, Spectrum.AtomicMismatch)) {
-    if (atomicEnergyDeficit == 0.) {
-      result *= SF::AtomicMismatchCorrection(W, W0, Z, A, betaType);
-      neutrinoResult *= SF::AtomicMismatchCorrection(Wv, W0, Z, A, betaType);
+  if (distributions.empty()) {
+    consoleLogger->error("No parameters to vary were given with MC.Parameter");
+    return;
+  }
+
+  std::size_t nSamples = config.Get<int>("MC.Samples");
+  uint64_t seed = config.Get<int>("MC.Seed");
+  int nThreads = utilities::GetThreadCount(config.Get<int>("Spectrum.Threads"));
+  double halflife = config.Exists("Transition.PartialHalflife") ? config.Get<double>("Transition.PartialHalflife") : 1.;
+
+  /**
+   * The samples are drawn up front so that the grid can extend to the largest
+   * sampled endpoint when the spectrum runs up to the endpoint
+   */
+  std::vector<TransitionParameters> samples(nSamples);
+  std::vector<std::vector<double> > deviations(nSamples);
+  double maxW0 = W0;
+  for (std::size_t i = 0; i < nSamples; i++) {
+    samples[i] = SampleTransitionParameters(distributions, seed, i, deviations[i]);
+    maxW0 = std::max(maxW0, samples[i].W0);
+  }
+  double beginW, endW;
+  std::tie(beginW, endW) = GetEnergyRange();
+  if (config.Get<double>("Spectrum.End") == 0.0) endW = maxW0;
+  std::vector<double> grid = BuildGrid(beginW, endW);
+  std::size_t n = grid.size();
+
+  /**
+   * Every sample starts from a copy of the nominal plan, in which only the
+   * corrections depending on a sampled parameter are bound again
+   */
+  const TransitionParameters nominal = GetTransitionParameters();
+  std::vector<double> nominalElectron(n), nominalNeutrino(n);
+  correctionPlan.Evaluate(grid.data(), nominalElectron.data(), nominalNeutrino.data(), n);
+  for (std::size_t j = 0; j < n; j++) {
+    if (grid[j] >= W0) nominalElectron[j] = nominalNeutrino[j] = 0.;
+  }
+
+  /**
+   * Samples are processed in fixed blocks whose sums are added in order, so
+   * that the results are identical for any number of threads. The sums are
+   * taken relative to the nominal spectrum to limit cancellation in the
+   * variance.
+   */
+  const std::size_t blockSize = 64;
+  std::size_t nBlocks = (nSamples + blockSize - 1) / blockSize;
+  std::vector<std::vector<double> > blockSums(nBlocks);
+  std::vector<double> logFt(nSamples), meanEnergy(nSamples);
+  utilities::ParallelFor(nBlocks, nThreads, 1, [&](std::size_t b) {
+    std::vector<double>& sums = blockSums[b];
+    sums.assign(4 * n, 0.);
+    std::vector<double> electron(n), neutrino(n);
+    for (std::size_t i = b * blockSize; i < std::min(nSamples, (b + 1) * blockSize); i++) {
+      CorrectionPlan plan = correctionPlan;
+#ifdef BSG_PROFILE_CORRECTIONS
+      plan.SetProfile(nullptr);
+#endif
+      BindCorrections(plan, samples[i], &nominal);
+      plan.Evaluate(grid.data(), electron.data(), neutrino.data(), n);
+      for (std::size_t j = 0; j < n; j++) {
+        if (grid[j] >= samples[i].W0) electron[j] = neutrino[j] = 0.;
+        double de = electron[j] - nominalElectron[j];
+        double dv = neutrino[j] - nominalNeutrino[j];
+        sums[j] += de;
+        sums[n + j] += de * de;
+        sums[2 * n + j] += dv;
+        sums[3 * n + j] += dv * dv;
+      }
+      double f = utilities::Simpson(grid.data(), electron.data(), n, 0);
+      logFt[i] = std::log10(f * halflife);
+      meanEnergy[i] = (utilities::Simpson(grid.data(), electron.data(), n, 1) / f - 1.) * ELECTRON_MASS_KEV;
     }
+  });
+
+  std::vector<double> sums(4 * n, 0.);
+  for (const std::vector<double>& block : blockSums) {
+    for (std::size_t j = 0; j < 4 * n; j++) sums[j] += block[j];
   }
-  // elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
-  // std::cout << "AM microseconds since start: " << elapsed.count() << "\n";
-  result = std::max(0., result);
-  neutrinoResult = std::max(0., neutrinoResult);
-  rawSpectrumLogger->info("{:<10f}\t{:<10f}\t{:<10f}\t{:<10f}", W, (W-1.)*ELECTRON_MASS_KEV, result, neutrinoResult);
-  // elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
-  // std::cout << "File microseconds since start: " << elapsed.count() << "\n";
-  return std::make_tuple(result, neutrinoResult);
+
+  /**
+   * Sample mean, standard deviation and 16, 50 and 84% quantiles of a
+   * derived quantity
+   */
+  auto summarize = [](std::vector<double> values) {
+    double mean = 0., variance = 0.;
+    for (double v : values) mean += v / values.size();
+    for (double v : values) variance += (v - mean) * (v - mean);
+    variance = values.size() > 1 ? variance / (values.size() - 1) : 0.;
+    std::sort(values.begin(), values.end());
+    auto quantile = [&values](double q) {
+      return values[std::min(values.size() - 1, (std::size_t)(q * values.size()))];
+    };
+    return fmt::format("{:.6f} +- {:.6f} (16%: {:.6f}, 50%: {:.6f}, 84%: {:.6f})", mean, std::sqrt(variance),
+                       quantile(0.16), quantile(0.50), quantile(0.84));
+  };
+
+  std::string outputName = config.Get<std::string>("output");
+  std::ofstream mcStream((outputName + ".mc").c_str());
+  mcStream << "# Monte Carlo uncertainties from " << nSamples << " samples with seed " << seed << std::endl;
+  for (const ParameterDistribution& d : distributions) {
+    mcStream << "# " << d.name << ": " << (d.shape == ParameterDistribution::NORMAL ? "normal, sigma " : "uniform, half width ")
+             << d.width << std::endl;
+  }
+  mcStream << "# log f(t): " << summarize(logFt) << std::endl;
+  mcStream << "# <E> [keV]: " << summarize(meanEnergy) << std::endl;
+  mcStream << "# W\tE [keV]\tElectron\tElectron sigma\tNeutrino\tNeutrino sigma" << std::endl;
+  for (std::size_t j = 0; j < n; j++) {
+    double moments[4];
+    for (int k = 0; k < 2; k++) {
+      double mean = sums[2 * k * n + j] / nSamples;
+      double variance = nSamples > 1 ? (sums[(2 * k + 1) * n + j] - mean * sums[2 * k * n + j]) / (nSamples - 1) : 0.;
+      moments[2 * k] = mean;
+      moments[2 * k + 1] = std::sqrt(std::max(0., variance));
+    }
+    mcStream << fmt::format("{:.6f}\t{:.6f}\t{:.8g}\t{:.8g}\t{:.8g}\t{:.8g}\n", grid[j],
+                            (grid[j] - 1.) * ELECTRON_MASS_KEV, nominalElectron[j] + moments[0], moments[1],
+                            nominalNeutrino[j] + moments[2], moments[3]);
+  }
+  mcStream.close();
+
+  std::ofstream samplesStream((outputName + ".mc.samples").c_str());
+  samplesStream << "# Sample";
+  for (const ParameterDistribution& d : distributions) samplesStream << "\t" << d.name;
+  samplesStream << "\tlog f(t)\t<E> [keV]" << std::endl;
+  for (std::size_t i = 0; i < nSamples; i++) {
+    samplesStream << i;
+    for (double x : deviations[i]) samplesStream << "\t" << fmt::format("{:.8g}", x);
+    samplesStream << fmt::format("\t{:.6f}\t{:.4f}", logFt[i], meanEnergy[i]) << std::endl;
+  }
+  samplesStream.close();
+
+  consoleLogger->info("log f(t) over {} samples: {}", nSamples, summarize(logFt));
+  consoleLogger->info("<E> [keV] over {} samples: {}", nSamples, summarize(meanEnergy));
+  debugFileLogger->info("Finished calculating uncertainties");
 }
 
-std::vector<std::vector<double> >* bsg::Generator::CalculateSpectrum() {
-  spectrum = new std::vector<std::vector<double> >();
-  // auto start = std::chrono::steady_clock::now();
-  debugFileLogger->info("Calculating spectrum");
-  double beginEn = GetBSGOpt(double, Spectrum.Begin);
-  double endEn = GetBSGOpt(double, Spectrum.End);
+bsg::SpectrumSampler bsg::Generator::GetSampler(bool neutrino) {
+  if (spectrum.IsEmpty()) CalculateSpectrum();
+  return SpectrumSampler(spectrum.GetW(), neutrino ? spectrum.GetNeutrino() : spectrum.GetElectron());
+}
+
+void bsg::Generator::GenerateEvents() {
+  std::size_t nEvents = config.Get<std::size_t>("Sampler.Events");
+  uint64_t seed = config.Get<int>("Sampler.Seed");
+  std::string particle = config.Get<std::string>("Sampler.Particle");
+  std::string format = config.Get<std::string>("Sampler.Format");
+  if (particle != "electron" && particle != "neutrino") {
+    consoleLogger->error("Unknown Sampler.Particle {}, use electron or neutrino", particle);
+    return;
+  }
+  if (format != "text" && format != "binary") {
+    consoleLogger->error("Unknown Sampler.Format {}, use text or binary", format);
+    return;
+  }
+  bool binary = format == "binary";
+  int nThreads = utilities::GetThreadCount(config.Get<int>("Spectrum.Threads"));
+
+  SpectrumSampler sampler = GetSampler(particle == "neutrino");
+  debugFileLogger->info("Sampling {} {} energies on {} thread(s)", nEvents, particle, nThreads);
+
+  std::string eventsName = config.Get<std::string>("output") + ".events";
+  std::FILE* file = std::fopen(eventsName.c_str(), binary ? "wb" : "w");
+  if (!file) {
+    consoleLogger->error("Failed to open events file {}", eventsName);
+    return;
+  }
+
+  /**
+   * Energies are sampled in blocks which are small enough to stay in memory
+   * and written while the next block is not yet sampled. Every thread fills
+   * whole pieces of a block, converting them to kinetic energies in keV and
+   * formatting them, so that writing is a single call per block.
+   */
+  const std::size_t blockSize = 1 << 22;
+  const std::size_t pieceSize = 1 << 14;
+  std::size_t nTest = std::min(nEvents, config.Get<std::size_t>("Sampler.Test"));
+  std::vector<double> testEnergies;
+  testEnergies.reserve(nTest);
+  std::vector<double> energies(std::min(nEvents, blockSize));
+  std::vector<std::string> text(binary ? 0 : (energies.size() + pieceSize - 1) / pieceSize);
+  double samplingTime = 0.;
+  auto start = std::chrono::steady_clock::now();
+
+  for (std::size_t first = 0; first < nEvents; first += blockSize) {
+    std::size_t n = std::min(blockSize, nEvents - first);
+    std::size_t nPieces = (n + pieceSize - 1) / pieceSize;
+    auto blockStart = std::chrono::steady_clock::now();
+    utilities::ParallelFor(nPieces, nThreads, 1, [&](std::size_t k) {
+      std::size_t begin = k * pieceSize;
+      Span<double> piece(energies.data() + begin, std::min(pieceSize, n - begin));
+      sampler.Sample(seed, first + begin, piece);
+      for (double& E : piece) E = (E - 1.) * ELECTRON_MASS_KEV;
+      if (!binary) {
+        text[k].clear();
+        char line[32];
+        for (double E : piece) text[k].append(line, std::snprintf(line, sizeof(line), "%.6f\n", E));
+      }
+    });
+    samplingTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - blockStart).count();
+
+    for (std::size_t i = 0; i < n && testEnergies.size() < nTest; i++) {
+      testEnergies.push_back(energies[i] / ELECTRON_MASS_KEV + 1.);
+    }
+    if (binary) {
+      std::vector<unsigned char> bytes(8 * n);
+      for (std::size_t i = 0; i < n; i++) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &energies[i], sizeof(bits));
+        for (int b = 0; b < 8; b++) bytes[8 * i + b] = (bits >> (8 * b)) & 0xff;
+      }
+      std::fwrite(bytes.data(), 1, bytes.size(), file);
+    } else {
+      for (std::size_t k = 0; k < nPieces; k++) std::fwrite(text[k].data(), 1, text[k].size(), file);
+    }
+  }
+  std::fclose(file);
+  double totalTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  consoleLogger->info("Sampled {} {} energies in {:.3f} s ({:.3g} per second), {:.3f} s including output",
+                      nEvents, particle, samplingTime, nEvents / std::max(samplingTime, 1e-9), totalTime);
+
+  Span<const double> W = spectrum.GetW();
+  GoodnessOfFit test = SpectrumSampler::TestGoodnessOfFit(
+      std::move(testEnergies), BuildReferenceCdf(W[0], W[W.size() - 1], particle == "neutrino"));
+  if (test.pValue < 1e-3) {
+    consoleLogger->warn("Kolmogorov-Smirnov test of {} sampled energies: D = {:.3g}, p = {:.3g}",
+                        test.n, test.statistic, test.pValue);
+  } else {
+    consoleLogger->info("Kolmogorov-Smirnov test of {} sampled energies: D = {:.3g}, p = {:.3g}",
+                        test.n, test.statistic, test.pValue);
+  }
+  debugFileLogger->info("Kolmogorov-Smirnov test: D = {}, p = {}", test.statistic, test.pValue);
+}
+
+std::tuple<double, double> bsg::Generator::GetEnergyRange() {
+  double beginEn = config.Get<double>("Spectrum.Begin");
+  double endEn = config.Get<double>("Spectrum.End");
 
   double beginW = beginEn / ELECTRON_MASS_KEV + 1.;
   double endW = endEn / ELECTRON_MASS_KEV + 1.;
   if (endEn == 0.0) {
     endW = W0;
   }
+  return std::make_tuple(beginW, endW);
+}
 
-  double stepW = GetBSGOpt(double, Spectrum.StepSize) / ELECTRON_MASS_KEV;
-  if (BSGOptExists(Spectrum.Steps)) {
-    stepW = (endW-beginW)/GetBSGOpt(int, Spectrum.Steps);
+/**
+ * Parameters of the integrand of the adaptive spectrum integrals
+ */
+struct SpectrumMomentParams {
+  const bsg::CorrectionPlan* plan;
+  int moment;
+  bool neutrino; /**< integrate the neutrino instead of the electron spectrum */
+  std::size_t evaluations;
+};
+
+static double SpectrumMomentIntegrand(double W, void* p) {
+  SpectrumMomentParams* params = static_cast<SpectrumMomentParams*>(p);
+  params->evaluations++;
+  std::tuple<double, double> rates = params->plan->Evaluate(W);
+  return std::pow(W, params->moment) * (params->neutrino ? std::get<1>(rates) : std::get<0>(rates));
+}
+
+bsg::SpectrumIntegral bsg::Generator::IntegrateSpectrum(int moment,
+                                                        double tolerance) {
+  double beginW, endW;
+  std::tie(beginW, endW) = GetEnergyRange();
+
+  SpectrumMomentParams params = {&correctionPlan, moment, false, 0};
+  gsl_function F;
+  F.function = &SpectrumMomentIntegrand;
+  F.params = &params;
+
+  /**
+   * QAGS extrapolates away the square-root behaviour of the spectrum at both
+   * ends, so that the requested tolerance is reached with a few hundred
+   * evaluations. Failures are reported instead of aborting, as the achieved
+   * error is still meaningful. The GSL error handler was turned off when
+   * constructing the Generator.
+   */
+  double result, error;
+  int status = gsl_integration_qags(&F, beginW, endW, 0., tolerance, 1000,
+                                    utilities::GetIntegrationWorkspace(),
+                                    &result, &error);
+
+  if (status) {
+    consoleLogger->warn("Integral of W^{} dN/dW did not reach relative tolerance {}: {}",
+                        moment, tolerance, gsl_strerror(status));
   }
+  debugFileLogger->debug("Integral of W^{} dN/dW: {} +- {} ({} evaluations)",
+                         moment, result, error, params.evaluations);
 
-  double currentW = beginW;
-  while (currentW <= endW) {
-    auto result = CalculateDecayRate(currentW);
-    std::vector<double> entry = {currentW, std::get<0>(result), std::get<1>(result)};
-    spectrum->push_back(entry);
-    currentW += stepW;
+  return {moment, result, error, params.evaluations};
+}
+
+std::function<double(double)> bsg::Generator::BuildReferenceCdf(double beginW, double endW,
+                                                                bool neutrino) {
+  const std::size_t nIntervals = 1000;
+  double tolerance = config.Get<double>("Spectrum.Tolerance");
+  double h = (endW - beginW) / nIntervals;
+
+  SpectrumMomentParams params = {&correctionPlan, 0, neutrino, 0};
+  gsl_function F;
+  F.function = &SpectrumMomentIntegrand;
+  F.params = &params;
+
+  std::vector<double> cdf(nIntervals + 1, 0.), density(nIntervals + 1);
+  for (std::size_t i = 0; i <= nIntervals; i++) {
+    double a = beginW + i * h;
+    density[i] = SpectrumMomentIntegrand(a, &params);
+    if (i == nIntervals) break;
+    double result, error;
+    gsl_integration_qags(&F, a, a + h, 0., tolerance, 1000, utilities::GetIntegrationWorkspace(), &result,
+                         &error);
+    cdf[i + 1] = cdf[i] + result;
   }
-  // auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
-  // std::cout << "microseconds since CalculateSpectrum: " << elapsed.count() << "\n";
+  debugFileLogger->debug("Reference distribution integrated with {} evaluations", params.evaluations);
+
+  double total = cdf[nIntervals];
+  if (!(total > 0.)) throw std::runtime_error("Spectrum integrates to zero, no distribution can be built");
+  for (std::size_t i = 0; i <= nIntervals; i++) {
+    cdf[i] /= total;
+    density[i] /= total;
+  }
+
+  return [=](double W) {
+    if (!(W > beginW)) return 0.;
+    if (!(W < endW)) return 1.;
+    std::size_t i = std::min(nIntervals - 1, (std::size_t)((W - beginW) / h));
+    double t = (W - beginW - i * h) / h;
+    double t2 = t * t, t3 = t2 * t;
+    double value = (2. * t3 - 3. * t2 + 1.) * cdf[i] + (t3 - 2. * t2 + t) * h * density[i] +
+                   (3. * t2 - 2. * t3) * cdf[i + 1] + (t3 - t2) * h * density[i + 1];
+    return std::min(1., std::max(0., value));
+  };
+}
+
+const std::vector<bsg::SpectrumIntegral>& bsg::Generator::CalculateIntegrals() {
+  debugFileLogger->info("Calculating spectrum integrals");
+  double tolerance = config.Get<double>("Spectrum.Tolerance");
+  int moments = std::max(1, config.Get<int>("Spectrum.Moments"));
+
+  integrals.clear();
+  for (int k = 0; k <= moments; k++) {
+    integrals.push_back(IntegrateSpectrum(k, tolerance));
+  }
+
   PrepareOutputFile();
-  // elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
-  // std::cout << "microseconds since CalculateSpectrum: " << elapsed.count() << "\n";
-  return spectrum;
+  return integrals;
+}
+
+double bsg::Generator::GetSpectrumMoment(int moment) {
+  if (moment < (int)integrals.size()) {
+    return integrals[moment].value;
+  }
+  return spectrum.Integrate(moment);
 }
 
 double bsg::Generator::CalculateLogFtValue(double partialHalflife) {
   debugFileLogger->debug("Calculating Ft value with partial halflife {}", partialHalflife);
-  double f = utilities::Simpson(*spectrum);
+  double f = GetSpectrumMoment(0);
   debugFileLogger->debug("f: {}", f);
   double ft = f*partialHalflife;
   double logFt = std::log10(ft);
@@ -546,97 +1442,119 @@ double bsg::Generator::CalculateLogFtValue(double partialHalflife) {
 
 double bsg::Generator::CalculateMeanEnergy() {
   debugFileLogger->debug("Calculating mean energy");
-  std::vector<std::vector<double> > weightedSpectrum;
-  for (int i =0; i < spectrum->size(); i++) {
-    std::vector<double> entry = {(*spectrum)[i][0], (*spectrum)[i][0]* (*spectrum)[i][1]};
-    weightedSpectrum.push_back(entry);
-  }
-  double weightedF = utilities::Simpson(weightedSpectrum);
-  double f = utilities::Simpson(*spectrum);
+  double weightedF = GetSpectrumMoment(1);
+  double f = GetSpectrumMoment(0);
   debugFileLogger->debug("Weighted f: {} Clean f: {}", weightedF, f);
   return weightedF/f;
 }
 
 void bsg::Generator::PrepareOutputFile() {
-  ShowBSGInfo();
+  if (!writeFiles) return;
+  auto l = resultsFileLogger;
+  ShowBSGInfo(l);
 
-  auto l = spdlog::get("BSG_results_file");
   l->info("Spectrum input overview\n{:=>30}", "");
-  //l->info("Using information from {}\n\n", GetBSGOpt(std::string, input));
+  //l->info("Using information from {}\n\n", config.Get<std::string>("input"));
   l->info("Transition from {}{} [{}/2] ({} keV) to {}{} [{}/2] ({} keV)", A, utilities::atoms[int(Z-1-betaType)], motherSpinParity, motherExcitationEn, A, utilities::atoms[int(Z-1)], daughterSpinParity, daughterExcitationEn);
   l->info("Q Value: {} keV\tEffective endpoint energy: {}", QValue, (W0-1.)*ELECTRON_MASS_KEV);
-  l->info("Process: {}\tType: {}", GetBSGOpt(std::string, Transition.Process), GetBSGOpt(std::string, Transition.Type));
+  l->info("Process: {}\tType: {}", config.Get<std::string>("Transition.Process"), config.Get<std::string>("Transition.Type"));
   if (mixingRatio != 0) l->info("Mixing ratio: {}", mixingRatio);
 
   // double BGT = fc1*fc1/(std::abs(motherSpinParity)+1)
   // double kappa = 6147.; // The combination of constants for the ft value in s
   // double ftTheory = std::log10(kappa/BGT);
   // l->info("");
-  if (BSGOptExists(Transition.PartialHalflife)) {
-    l->info("Partial halflife: {} s", GetBSGOpt(double, Transition.PartialHalflife));
-    l->info("Calculated log ft value: {}", CalculateLogFtValue(GetBSGOpt(double, Transition.PartialHalflife)));
+  if (config.Exists("Transition.PartialHalflife")) {
+    l->info("Partial halflife: {} s", config.Get<double>("Transition.PartialHalflife"));
+    l->info("Calculated log ft value: {}", CalculateLogFtValue(config.Get<double>("Transition.PartialHalflife")));
   } else {
     l->info("Partial halflife: not given");
     l->info("Calculated log f value: {}", CalculateLogFtValue(1.0));
   }
-  if (BSGOptExists(Transition.LogFt)) {
-    l->info("External Log ft: {:.3f}", GetBSGOpt(double, Transition.LogFt));
-    if (BSGOptExists(Transition.PartialHalflife)) {
+  if (config.Exists("Transition.LogFt")) {
+    l->info("External Log ft: {:.3f}", config.Get<double>("Transition.LogFt"));
+    if (config.Exists("Transition.PartialHalflife")) {
       l->info("Ratio of calculated/external ft value: {}", std::pow(10.,
-        CalculateLogFtValue(GetBSGOpt(double, Transition.PartialHalflife))
-         - GetBSGOpt(double, Transition.LogFt)));
+        CalculateLogFtValue(config.Get<double>("Transition.PartialHalflife"))
+         - config.Get<double>("Transition.LogFt")));
     }
   }
   l->info("Mean energy: {} keV", (CalculateMeanEnergy()-1.)*ELECTRON_MASS_KEV);
+  if (!integrals.empty()) {
+    double meanRelError = std::sqrt(std::pow(integrals[0].error/integrals[0].value, 2.)
+                                    + std::pow(integrals[1].error/integrals[1].value, 2.));
+    l->info("Relative error on f: {:.3g}\tRelative error on mean energy: {:.3g}",
+            integrals[0].error/integrals[0].value, meanRelError);
+  }
   l->info("\nMatrix Element Summary\n{:->30}", "");
-  if (BSGOptExists(Spectrum.WeakMagnetism)) l->info("{:35}: {} ({})", "b/Ac (weak magnetism)", bAc, "given");
-  else l->info("{:35}: {}", "b/Ac (weak magnetism)", bAc);
-  if (BSGOptExists(Spectrum.Inducedtensor)) l->info("{:35}: {} ({})", "d/Ac (induced tensor)", dAc, "given");
-  else l->info("{:35}: {}", "d/Ac (induced tensor)", dAc);
-  if (BSGOptExists(Spectrum.Lambda)) l->info("{:35}: {} ({})", "AM121/AM101", ratioM121, "given");
-  else l->info("{:35}: {}", "AM121/AM101", ratioM121);
+  if (!matrixElementsCalculated) {
+    l->info("Not required by the enabled corrections");
+  } else {
+    if (config.Exists("Spectrum.WeakMagnetism")) l->info("{:35}: {} ({})", "b/Ac (weak magnetism)", bAc, "given");
+    else l->info("{:35}: {}", "b/Ac (weak magnetism)", bAc);
+    if (config.Exists("Spectrum.Inducedtensor")) l->info("{:35}: {} ({})", "d/Ac (induced tensor)", dAc, "given");
+    else l->info("{:35}: {}", "d/Ac (induced tensor)", dAc);
+    if (config.Exists("Spectrum.Lambda")) l->info("{:35}: {} ({})", "AM121/AM101", ratioM121, "given");
+    else l->info("{:35}: {}", "AM121/AM101", ratioM121);
 
-  l->info("Full breakdown written in {}.nme", outputName);
+    if (nsm) l->info("Full breakdown written in {}.nme", outputName);
+  }
 
   l->info("\nSpectral corrections\n{:->30}", "");
-  l->info("{:25}: {}", "Phase space", GetBSGOpt(bool, Spectrum.Phasespace));
-  l->info("{:25}: {}", "Fermi function", GetBSGOpt(bool, Spectrum.Fermi));
-  l->info("{:25}: {}", "L0 correction", GetBSGOpt(bool, Spectrum.ESFiniteSize));
-  l->info("{:25}: {}", "C correction", GetBSGOpt(bool, Spectrum.C));
-  l->info("    NS Shape: {}", GetBSGOpt(std::string, Spectrum.NSShape));
-  l->info("{:25}: {}", "Isovector correction", GetBSGOpt(bool, Spectrum.Isovector));
-  l->info("    Connected: {}", GetBSGOpt(bool, Spectrum.Connect));
-  l->info("{:25}: {}", "Relativistic terms", GetBSGOpt(bool, Spectrum.Relativistic));
-  l->info("{:25}: {}", "Deformation", GetBSGOpt(bool, Spectrum.ESDeformation));
-  l->info("{:25}: {}", "U correction", GetBSGOpt(bool, Spectrum.U));
-  l->info("    ES Shape: {}", GetBSGOpt(std::string, Spectrum.ESShape));
-  if (BSGOptExists(Spectrum.vold) && BSGOptExists(Spectrum.vnew)) {
+  l->info("{:25}: {}", "Phase space", config.Get<bool>("Spectrum.Phasespace"));
+  l->info("{:25}: {}", "Fermi function", config.Get<bool>("Spectrum.Fermi"));
+  l->info("{:25}: {}", "L0 correction", config.Get<bool>("Spectrum.ESFiniteSize"));
+  l->info("{:25}: {}", "C correction", config.Get<bool>("Spectrum.C"));
+  l->info("    NS Shape: {}", config.Get<std::string>("Spectrum.NSShape"));
+  l->info("{:25}: {}", "Isovector correction", config.Get<bool>("Spectrum.Isovector"));
+  l->info("    Connected: {}", config.Get<bool>("Spectrum.Connect"));
+  l->info("{:25}: {}", "Relativistic terms", config.Get<bool>("Spectrum.Relativistic"));
+  l->info("{:25}: {}", "Deformation", config.Get<bool>("Spectrum.ESDeformation"));
+  l->info("{:25}: {}", "U correction", config.Get<bool>("Spectrum.U"));
+  l->info("    ES Shape: {}", config.Get<std::string>("Spectrum.ESShape"));
+  if (config.Exists("Spectrum.vold") && config.Exists("Spectrum.vnew")) {
     l->info("    v : {}, {}, {}", vOld[0], vOld[1], vOld[2]);
     l->info("    v': {}, {}, {}", vNew[0], vNew[1], vNew[2]);
   } else {
     l->info("    v : not given");
     l->info("    v': not given");
   }
-  l->info("{:25}: {}", "Q correction", GetBSGOpt(bool, Spectrum.CoulombRecoil));
-  l->info("{:25}: {}", "Radiative correction", GetBSGOpt(bool, Spectrum.Radiative));
-  l->info("{:25}: {}", "Nuclear recoil", GetBSGOpt(bool, Spectrum.Recoil));
-  l->info("{:25}: {}", "Atomic screening", GetBSGOpt(bool, Spectrum.Screening));
-  l->info("{:25}: {}", "Atomic exchange", GetBSGOpt(bool, Spectrum.Exchange));
-  l->info("{:25}: {}", "Atomic mismatch", GetBSGOpt(bool, Spectrum.AtomicMismatch));
-  l->info("{:25}: {}", "Export neutrino", GetBSGOpt(bool, Spectrum.Neutrino));
+  l->info("{:25}: {}", "Q correction", config.Get<bool>("Spectrum.CoulombRecoil"));
+  l->info("{:25}: {}", "Radiative correction", config.Get<bool>("Spectrum.Radiative"));
+  l->info("{:25}: {}", "Nuclear recoil", config.Get<bool>("Spectrum.Recoil"));
+  l->info("{:25}: {}", "Atomic screening", config.Get<bool>("Spectrum.Screening"));
+  l->info("{:25}: {}", "Atomic exchange", config.Get<bool>("Spectrum.Exchange"));
+  l->info("{:25}: {}", "Atomic mismatch", config.Get<bool>("Spectrum.AtomicMismatch"));
+  l->info("{:25}: {}", "Export neutrino", config.Get<bool>("Spectrum.Neutrino"));
+  l->info("{:25}: {}", "Interpolated spectrum", config.Get<bool>("Spectrum.Interpolate"));
+
+  if (!integrals.empty()) {
+    l->info("\n\nSpectrum integrated adaptively from {} keV to {} keV with relative tolerance {}\n",
+    config.Get<double>("Spectrum.Begin"),
+    config.Get<double>("Spectrum.End") > 0 ? config.Get<double>("Spectrum.End") : (W0-1.)*ELECTRON_MASS_KEV, config.Get<double>("Spectrum.Tolerance"));
+    l->info("{:10}\t{:20}\t{:10}\t{:10}", "Moment", "Int W^k dN_e/dW", "Error", "Evaluations");
+    for (const SpectrumIntegral& integral : integrals) {
+      l->info("{:<10}\t{:<20.12e}\t{:<10.3e}\t{:<10}", integral.moment, integral.value, integral.error, integral.evaluations);
+    }
+    return;
+  }
 
   l->info("\n\nSpectrum calculated from {} keV to {} keV with step size {} keV\n",
-  GetBSGOpt(double, Spectrum.Begin),
-  GetBSGOpt(double, Spectrum.End) > 0 ? GetBSGOpt(double, Spectrum.End) : (W0-1.)*ELECTRON_MASS_KEV, GetBSGOpt(double, Spectrum.StepSize));
+  config.Get<double>("Spectrum.Begin"),
+  config.Get<double>("Spectrum.End") > 0 ? config.Get<double>("Spectrum.End") : (W0-1.)*ELECTRON_MASS_KEV, config.Get<double>("Spectrum.StepSize"));
 
-  if (GetBSGOpt(bool, Spectrum.Neutrino))  l->info("{:10}\t{:10}\t{:10}\t{:10}", "W [m_ec2]", "E [keV]", "dN_e/dW", "dN_v/dW");
+  if (config.Get<bool>("Spectrum.Neutrino"))  l->info("{:10}\t{:10}\t{:10}\t{:10}", "W [m_ec2]", "E [keV]", "dN_e/dW", "dN_v/dW");
   else l->info("{:10}\t{:10}\t{:10}", "W [m_ec2]", "E [keV]", "dN_e/dW");
 
-  for (int i = 0; i < spectrum->size(); i++) {
-    if (GetBSGOpt(bool, Spectrum.Neutrino)) {
-      l->info("{:<10f}\t{:<10f}\t{:<10f}\t{:<10f}", (*spectrum)[i][0], ((*spectrum)[i][0]-1.)*ELECTRON_MASS_KEV, (*spectrum)[i][1], (*spectrum)[i][2]);
+  bool neutrino = config.Get<bool>("Spectrum.Neutrino");
+  Span<const double> W = spectrum.GetW();
+  Span<const double> electron = spectrum.GetElectron();
+  Span<const double> neutrinoSpectrum = spectrum.GetNeutrino();
+  for (size_t i = 0; i < W.size(); i++) {
+    if (neutrino) {
+      l->info("{:<10f}\t{:<10f}\t{:<10f}\t{:<10f}", W[i], (W[i]-1.)*ELECTRON_MASS_KEV, electron[i], neutrinoSpectrum[i]);
     } else {
-      l->info("{:<10f}\t{:<10f}\t{:<10f}", (*spectrum)[i][0], ((*spectrum)[i][0]-1.)*ELECTRON_MASS_KEV, (*spectrum)[i][1]);
+      l->info("{:<10f}\t{:<10f}\t{:<10f}", W[i], (W[i]-1.)*ELECTRON_MASS_KEV, electron[i]);
     }
   }
 }
@@ -0,0 +1,130 @@
+#include "GeneratorConfig.h"
+#include "BSGOptionContainer.h"
+#include "NMEOptionContainer.h"
+
+#include <cstddef>
+#include <fstream>
+#include <sstream>
+#include <typeinfo>
+#include <boost/program_options/parsers.hpp>
+
+bsg::GeneratorConfig bsg::GeneratorConfig::FromOptions() {
+  return GeneratorConfig(
+      BSGOptionContainer::GetInstance().GetVariablesMap(),
+      nme::NMEOptionContainer::GetInstance().GetVariablesMap());
+}
+
+bool bsg::GeneratorConfig::ReadInput(std::string inputName) {
+  std::ifstream bsgStream(inputName.c_str());
+  std::ifstream nmeStream(inputName.c_str());
+  if (!bsgStream.is_open() || !nmeStream.is_open()) return false;
+
+  po::store(po::parse_config_file(
+                bsgStream, BSGOptionContainer::GetTransitionOptions(), true),
+            bsgOptions);
+  po::store(po::parse_config_file(
+                nmeStream,
+                nme::NMEOptionContainer::GetInstance().GetTransitionOptions(),
+                true),
+            nmeOptions);
+  Set("input", inputName);
+  return true;
+}
+
+bool bsg::GeneratorConfig::ReadConfig(std::string configName) {
+  std::ifstream bsgStream(configName.c_str());
+  std::ifstream nmeStream(configName.c_str());
+  if (!bsgStream.is_open() || !nmeStream.is_open()) return false;
+
+  po::store(po::parse_config_file(
+                bsgStream, BSGOptionContainer::GetConfigOptions(), true),
+            bsgOptions);
+  po::store(po::parse_config_file(
+                nmeStream,
+                nme::NMEOptionContainer::GetInstance().GetConfigOptions(),
+                true),
+            nmeOptions);
+  return true;
+}
+
+/**
+ * Parse name=value lines with the given options and move the values which
+ * were given explicitly into vm
+ */
+static bool OverrideOptions(po::variables_map& vm, const po::options_description& description,
+                            const std::string& text) {
+  std::istringstream stream(text);
+  po::variables_map parsed;
+  po::store(po::parse_config_file(stream, description, true), parsed);
+  bool found = false;
+  for (const auto& option : parsed) {
+    if (option.second.defaulted()) continue;
+    vm.erase(option.first);
+    vm.insert(option);
+    found = true;
+  }
+  return found;
+}
+
+bool bsg::GeneratorConfig::Override(std::string name, std::vector<std::string> values) {
+  std::string text;
+  for (const std::string& value : values) text += name + "=" + value + "\n";
+
+  po::options_description bsgDescription;
+  bsgDescription.add(BSGOptionContainer::GetGenericOptions())
+      .add(BSGOptionContainer::GetConfigOptions())
+      .add(BSGOptionContainer::GetTransitionOptions());
+  try {
+    bool found = OverrideOptions(bsgOptions, bsgDescription, text);
+    po::options_description nmeDescription;
+    nmeDescription.add(nme::NMEOptionContainer::GetInstance().GetConfigOptions())
+        .add(nme::NMEOptionContainer::GetInstance().GetTransitionOptions());
+    found = OverrideOptions(nmeOptions, nmeDescription, text) || found;
+    return found;
+  } catch (po::error& e) {
+    return false;
+  }
+}
+
+void bsg::GeneratorConfig::SetOption(po::variables_map& vm, std::string name,
+                                     boost::any value) {
+  vm.erase(name);
+  vm.insert(std::make_pair(name, po::variable_value(value, false)));
+}
+
+/**
+ * Format the value of an option, with doubles at full precision
+ */
+static std::string FormatValue(const boost::any& value) {
+  std::ostringstream stream;
+  stream.precision(17);
+  if (const bool* b = boost::any_cast<bool>(&value)) {
+    stream << *b;
+  } else if (const int* i = boost::any_cast<int>(&value)) {
+    stream << *i;
+  } else if (const std::size_t* n = boost::any_cast<std::size_t>(&value)) {
+    stream << *n;
+  } else if (const double* d = boost::any_cast<double>(&value)) {
+    stream << *d;
+  } else if (const std::string* text = boost::any_cast<std::string>(&value)) {
+    stream << *text;
+  } else if (const std::vector<double>* v = boost::any_cast<std::vector<double> >(&value)) {
+    for (double d : *v) stream << d << ",";
+  } else if (const std::vector<std::string>* v = boost::any_cast<std::vector<std::string> >(&value)) {
+    for (const std::string& text : *v) stream << text << ",";
+  } else {
+    stream << "<" << value.type().name() << ">";
+  }
+  return stream.str();
+}
+
+std::string bsg::GeneratorConfig::ToString() const {
+  std::string result;
+  for (const po::variables_map* vm : {&bsgOptions, &nmeOptions}) {
+    for (const auto& option : *vm) {
+      result += option.first + "=" + FormatValue(option.second.value()) + "\n";
+    }
+    result += "\n";
+  }
+  return result;
+}
@@ -0,0 +1,100 @@
+#include "RawSpectrumWriter.h"
+#include "Constants.h"
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include "spdlog/fmt/fmt.h"
+
+/**
+ * Store a double as 8 little-endian bytes, independent of the host
+ */
+static void PutLittleEndian(double value, unsigned char* out) {
+  std::uint64_t bits;
+  std::memcpy(&bits, &value, sizeof(bits));
+  for (int i = 0; i < 8; i++) out[i] = (bits >> (8 * i)) & 0xff;
+}
+
+bsg::RawSpectrumWriter::RawSpectrumWriter(std::string filename, Format format,
+                                          std::size_t capacity)
+    : format(format), queue(capacity) {
+  file = std::fopen(filename.c_str(), format == BINARY ? "wb" : "w");
+  if (!file) {
+    throw std::runtime_error("Failed to open raw spectrum file " + filename);
+  }
+  worker = std::thread(&RawSpectrumWriter::Run, this);
+}
+
+bsg::RawSpectrumWriter::~RawSpectrumWriter() {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    done.store(true);
+  }
+  wakeup.notify_one();
+  worker.join();
+  std::fclose(file);
+}
+
+void bsg::RawSpectrumWriter::Push(double W, double electron, double neutrino) {
+  RawSpectrumRecord record = {W, (W - 1.) * ELECTRON_MASS_KEV, electron,
+                              neutrino};
+  while (!queue.TryPush(record)) std::this_thread::yield();
+  pushed.fetch_add(1);
+  // the lock is only taken to wake up the background thread once
+  if (sleeping.exchange(false)) {
+    std::lock_guard<std::mutex> lock(mutex);
+    wakeup.notify_one();
+  }
+}
+
+void bsg::RawSpectrumWriter::Flush() {
+  std::unique_lock<std::mutex> lock(mutex);
+  flushing.store(true);
+  drained.wait(lock, [this] { return written.load() >= pushed.load(); });
+  flushing.store(false);
+  lock.unlock();
+  std::fflush(file);
+}
+
+void bsg::RawSpectrumWriter::Run() {
+  RawSpectrumRecord record;
+  while (true) {
+    if (queue.TryPop(record)) {
+      Write(record);
+      written.fetch_add(1);
+      if (flushing.load() && written.load() >= pushed.load()) {
+        std::lock_guard<std::mutex> lock(mutex);
+        drained.notify_all();
+      }
+    } else if (done.load()) {
+      // records pushed before the destructor was called are all visible now
+      if (!queue.TryPop(record)) break;
+      Write(record);
+      written.fetch_add(1);
+    } else {
+      // the flag is set before checking for new records, and Push increments
+      // the count before checking the flag, so no wakeup can be missed
+      std::unique_lock<std::mutex> lock(mutex);
+      sleeping.store(true);
+      wakeup.wait(lock, [this] { return written.load() < pushed.load() || done.load(); });
+      sleeping.store(false);
+    }
+  }
+}
+
+void bsg::RawSpectrumWriter::Write(const RawSpectrumRecord& record) {
+  if (format == BINARY) {
+    unsigned char bytes[4 * 8];
+    PutLittleEndian(record.W, bytes);
+    PutLittleEndian(record.E, bytes + 8);
+    PutLittleEndian(record.electron, bytes + 16);
+    PutLittleEndian(record.neutrino, bytes + 24);
+    std::fwrite(bytes, sizeof(bytes), 1, file);
+  } else {
+    std::string line = fmt::format("{:<10f}\t{:<10f}\t{:<10f}\t{:<10f}\n",
+                                   record.W, record.E, record.electron,
+                                   record.neutrino);
+    std::fwrite(line.data(), 1, line.size(), file);
+  }
+}
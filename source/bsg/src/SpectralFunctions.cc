@@ -4,6 +4,7 @@
 #include "ChargeDistributions.h"
 #include "Screening.h"
 
+#include <algorithm>
 #include <complex>
 #include <stdio.h>
 
@@ -53,6 +54,39 @@ double bsg::SpectralFunctions::FermiFunction(double W, int Z, double R,
   return result;
 }
 
+bsg::SpectralFunctions::FermiFunctionConstants
+bsg::SpectralFunctions::PrepareFermiFunction(int Z, double R, int betaType) {
+  FermiFunctionConstants c;
+  c.gamma = std::sqrt(1. - std::pow(ALPHA * Z, 2.));
+  c.first = 2. * (c.gamma + 1.);
+  // the second term, 1/Gamma(2 gamma + 1)^2, will be incorporated in the fifth
+  c.lnGamma = gsl_sf_lngamma(2. * c.gamma + 1.);
+  c.twoR = 2. * R;
+  c.alphaZ = betaType * ALPHA * Z;
+  return c;
+}
+
+double bsg::SpectralFunctions::FermiFunction(double W,
+                                        const FermiFunctionConstants& c) {
+  double p = std::sqrt(W * W - 1.);
+  double y = c.alphaZ * W / p;
+  double third = std::pow(c.twoR * p, 2. * (c.gamma - 1.));
+  double fourth = std::exp(M_PI * y);
+
+  // the fifth is a bit tricky
+  // we use the complex gamma function from GSL
+  gsl_sf_result magn;
+  gsl_sf_result phase;
+  gsl_sf_lngamma_complex_e(c.gamma, y, &magn, &phase);
+  // now we have what we wAt in magn.val
+
+  // but we incorporate the second term here as well
+  double fifth = std::exp(2. * (magn.val - c.lnGamma));
+
+  double result = c.first * third * fourth * fifth;
+  return result;
+}
+
 double bsg::SpectralFunctions::CCorrection(double W, double W0, int Z, int A,
                                       double R, int betaType,
                                       int decayType, double gA, double gP,
@@ -178,6 +212,83 @@ std::tuple<double, double> bsg::SpectralFunctions::CCorrectionComponents(
   return std::make_tuple(cShape, cNS);
 }
 
+bsg::SpectralFunctions::CCorrectionConstants
+bsg::SpectralFunctions::PrepareCCorrection(
+    double W0, int Z, int A, double R, int betaType, int decayType, double gA,
+    double gP, double fc1, double fb, double fd, double ratioM121,
+    std::string NSShape, double hoFit) {
+  CCorrectionConstants c = {};
+
+  //Uniformly charged sphere results
+  double F1111 = 27./35.;
+  double F1221 = 57./70.;
+  double F1222 = 233./210.;
+  double F1211 = -3./70.;
+
+  if (boost::iequals(NSShape, "ModGauss")) {
+    F1111 = 0.757 + 0.0069 * (1 - std::exp(-hoFit / 1.008));
+    F1221 = 0.844 - 0.0182 * (1 - std::exp(-hoFit / 1.974));
+    F1222 = 1.219 - 0.0640 * (1 - std::exp(-hoFit / 1.550));
+  }
+
+  if (decayType == FERMI) {
+    c.shape = true;
+    c.C0 = -std::pow(W0 * R, 2.) / 5. -
+           betaType * 2. / 9. * ALPHA * Z * W0 * R * F1111 -
+           std::pow(ALPHA * Z, 2.) / 3. * F1222;
+
+    c.C1 = 4. / 15. * W0 * R * R -
+           betaType * 2. / 3. * ALPHA * Z * R * (F1221 - F1111 / 3.);
+
+    c.Cm1 = 2. / 15. * W0 * R * R - betaType * ALPHA * Z * R / 3. * F1211;
+
+    c.C2 = -4. / 15. * R * R;
+  } else if (decayType == GAMOW_TELLER) {
+    c.shape = true;
+    c.C0 = -1. / 3. * std::pow(ALPHA * Z, 2.) * F1222 -
+           1. / 5. * (W0 * W0 - 1.) * R * R +
+           betaType * 2. / 27. * ALPHA * Z * W0 * R * F1111 + 11. / 45. * R * R;
+
+    c.C1 = 4. / 9. * W0 * R * R -
+           betaType * 2. / 3. * ALPHA * Z * R * (1. / 9. * F1111 + F1221);
+
+    c.Cm1 = -2. / 45. * W0 * R * R + betaType * ALPHA * Z * R / 3. * F1211;
+
+    c.C2 = -4. / 9. * R * R;
+  }
+
+  if (decayType == GAMOW_TELLER) {
+    double M = A * NUCLEON_MASS_KEV / ELECTRON_MASS_KEV;
+
+    double Lambda = std::sqrt(2.)/3.*10.*ratioM121;
+
+    c.phi = gP/gA/sqr(2.*M*R/A);
+
+    c.NSC0 = -1. / 45. * R * R * Lambda +
+             1. / 3. * W0 / M / fc1 * (-betaType * 2. * fb + fd) +
+             betaType * 2. / 5. * ALPHA * Z / M / R / fc1 *
+                 (betaType * 2. * fb + fd) -
+             betaType * 2. / 35. * ALPHA * Z * W0 * R * Lambda;
+
+    c.NSC1 = betaType * 4. / 3. * fb / M / fc1 -
+             2. / 45. * W0 * R * R * Lambda +
+             betaType * ALPHA * Z * R * 2. / 35. * Lambda;
+
+    c.NSCm1 = -1. / 3. / M / fc1 * (betaType * 2. * fb + fd) +
+              2. / 45. * W0 * R * R * Lambda;
+
+    c.NSC2 = 2. / 45. * R * R * Lambda;
+
+    double gamma = std::sqrt(1.-sqr(ALPHA*Z));
+
+    c.P0 = betaType*2./25.*ALPHA*Z*R*W0 + 51./250.*sqr(ALPHA*Z);
+    c.P1 = betaType*2./25.*ALPHA*Z*R;
+    c.Pm1 = -2./3.*gamma*W0*R*R+betaType*26./25.*ALPHA*Z*R*gamma;
+  }
+
+  return c;
+}
+
 double bsg::SpectralFunctions::CICorrection(double W, double W0, int Z, int A,
                                        double R, int betaType) {
   double AC0, AC1, AC2, ACm1;
@@ -216,6 +327,32 @@ double bsg::SpectralFunctions::CICorrection(double W, double W0, int Z, int A,
   return 1 - 8. / 5. * w * e * R * R / (5. * Ap + 2);
 }
 
+bsg::SpectralFunctions::CICorrectionConstants
+bsg::SpectralFunctions::PrepareCICorrection(double W0, int Z, int A, double R,
+                                            int betaType) {
+  int nZ, lZ;
+  std::vector<int> occNumbersZ = utilities::GetOccupationNumbers(Z - betaType);
+  nZ = occNumbersZ[occNumbersZ.size() - 1 - 3];
+  lZ = occNumbersZ[occNumbersZ.size() - 1 - 2];
+
+  double w = (4 * nZ + 2 * lZ - 1) / 5.;
+
+  double Ap = 1.;
+  double sum = 0.;
+  for (int j = 0; j < occNumbersZ.size(); j += 4) {
+    if (occNumbersZ[j + 1] == 0) {
+      sum += occNumbersZ[j + 3];
+    }
+  }
+  Ap = (2. * (Z - betaType) / sum - 2.) / 3.;
+
+  CICorrectionConstants c;
+  c.W0 = W0;
+  c.V0 = betaType * 3 * ALPHA * Z / 2. / R;
+  c.a1 = 8. / 5. * w * R * R / (5. * Ap + 2);
+  return c;
+}
+
 double bsg::SpectralFunctions::CICorrection(
     double W, double W0, double Z, double R, int betaType,
     nme::NuclearStructure::SingleParticleState& spsi,
@@ -250,6 +387,45 @@ double bsg::SpectralFunctions::CICorrection(
   return result;
 }
 
+bsg::SpectralFunctions::CICorrectionConstants
+bsg::SpectralFunctions::PrepareCICorrection(
+    double W0, double Z, double R, int betaType,
+    nme::NuclearStructure::SingleParticleState& spsi,
+    nme::NuclearStructure::SingleParticleState& spsf) {
+  double nu = ChargeDistributions::CalcNu(R * std::sqrt(3. / 5.), Z);
+
+  // the overlap is sum_ij C_ij^2 I_ij (I_ij - 2 epsilon r2_ij), so only the
+  // two sums over the radial matrix elements need to be stored
+  double S0 = 0., S1 = 0.;
+  double C = 0.;
+  for (int i = 0; i < spsi.componentsHO.size(); i++) {
+    for (int j = 0; j < spsf.componentsHO.size(); j++) {
+      if ((spsf.componentsHO[j].n == spsi.componentsHO[i].n) &&
+          (spsf.componentsHO[j].l == spsi.componentsHO[i].l)) {
+        double I = ChargeDistributions::GetRadialMEHO(
+            spsf.componentsHO[j].n, spsf.componentsHO[j].l, 0,
+            spsi.componentsHO[i].n, spsi.componentsHO[i].l, nu);
+        double r2 = ChargeDistributions::GetRadialMEHO(
+            spsf.componentsHO[j].n, spsf.componentsHO[j].l, 2,
+            spsi.componentsHO[i].n, spsi.componentsHO[i].l, nu);
+
+        double C2 = sqr(spsf.componentsHO[j].C * spsi.componentsHO[i].C);
+        S0 += C2 * I * I;
+        S1 += C2 * I * r2;
+        C += C2;
+      }
+    }
+  }
+
+  CICorrectionConstants c;
+  c.W0 = W0;
+  c.V0 = betaType * 3. * Z * ALPHA / 2. / R;
+  c.a0 = S0 / C;
+  c.a1 = 2. * S1 / C;
+  c.b1 = 6. / 5. * R * R;
+  return c;
+}
+
 double bsg::SpectralFunctions::RelativisticCorrection(double W, double W0, int Z,
                                                  int A, double R, int betaType,
                                                  int decayType) {
@@ -286,6 +462,21 @@ double bsg::SpectralFunctions::RelativisticCorrection(double W, double W0, int Z
   }
 }
 
+bsg::SpectralFunctions::RelativisticCorrectionConstants
+bsg::SpectralFunctions::PrepareRelativisticCorrection(double W0, int Z, int A,
+                                                      double R, int betaType,
+                                                      int decayType) {
+  RelativisticCorrectionConstants c;
+  c.fermi = (decayType == FERMI);
+  c.W0 = W0;
+  c.R = R;
+  c.V0 = betaType * 3 * ALPHA * Z / (2. * R);
+  c.gamma = std::sqrt(1. - std::pow(ALPHA * Z, 2.));
+  c.mismatch = W0 - betaType * 2.5 + betaType * 6. / 5. * ALPHA * Z / R;
+  c.D3c = betaType * ALPHA * Z / 10.;
+  return c;
+}
+
 struct my_L0_params {double a; double b; double W; int Z; int betaType; double * aPos; double * aNeg;};
 
 double L0Integral(double r, void * p) {
@@ -295,13 +486,11 @@ double L0Integral(double r, void * p) {
   double W = (params->W);
   int Z = (params->Z);
   int betaType = (params->betaType);
-  double aPos[7] = {*(params->aPos)};
-  double aNeg[7] = {*(params->aNeg)};
   double gamma = std::sqrt(1. - std::pow(bsg::ALPHA * Z, 2.));
 
   return std::pow(r, 3.) *
    abs(bsg::ChargeDistributions::GetDerivDeformedChargeDist(r, a, b))
-   * bsg::SpectralFunctions::L0Correction(W, Z, r, betaType, aPos, aNeg)
+   * bsg::SpectralFunctions::L0Correction(W, Z, r, betaType, params->aPos, params->aNeg)
    * std::pow(r, 2. * (gamma - 1));
 }
 
@@ -309,6 +498,10 @@ double bsg::SpectralFunctions::DeformationCorrection(double W, double W0, int Z,
                                                 double R, double beta2,
                                                 int betaType, double aPos[],
                                                 double aNeg[]) {
+  // for a spherical nucleus the derivative of the charge distribution is a
+  // delta function at R, so that the correction is 1, while the integral
+  // below runs over the empty range from a = b = R
+  if (beta2 == 0.) return 1.;
   double bOverA = ChargeDistributions::CalcBoverA(beta2);
   double a, b;
 
@@ -334,9 +527,6 @@ double bsg::SpectralFunctions::DeformationCorrection(double W, double W0, int Z,
   double gamma = std::sqrt(1. - std::pow(ALPHA * Z, 2.));
   double prefact = 4. / 3. * M_PI * std::pow(R, 2. * (1 - gamma));
 
-  gsl_integration_workspace * w
-    = gsl_integration_workspace_alloc (1000);
-
   double result, error;
 
   struct my_L0_params params = {a, b, W, Z, betaType, aPos, aNeg};
@@ -345,16 +535,56 @@ double bsg::SpectralFunctions::DeformationCorrection(double W, double W0, int Z,
   F.function = &L0Integral;
   F.params = &params;
 
+  // this is called from within the integration of the spectrum, so it needs
+  // a workspace of its own
   gsl_integration_qags (&F, a, b, a, 1e-7, 1000,
-                        w, &result, &error);
+                        utilities::GetIntegrationWorkspace(1), &result, &error);
 
   double DFS = prefact * result / L0Correction(W, Z, R, betaType, aPos, aNeg);
 
-  gsl_integration_workspace_free (w);
-
   return DC0 * DFS;
 }
 
+bsg::SpectralFunctions::DeformationCorrectionConstants
+bsg::SpectralFunctions::PrepareDeformationCorrection(
+    double W0, int Z, double R, double beta2, int betaType,
+    const double aPos[], const double aNeg[], double tolerance) {
+  DeformationCorrectionConstants c;
+  c.W0 = W0;
+  c.R = R;
+  c.beta2 = beta2;
+  c.Z = Z;
+  c.betaType = betaType;
+  std::copy(aPos, aPos + 7, c.aPos);
+  std::copy(aNeg, aNeg + 7, c.aNeg);
+
+  // the integrand is smooth in W, so a handful of polynomial pieces suffices
+  double* pos = c.aPos;
+  double* neg = c.aNeg;
+  c.table = utilities::PiecewiseChebyshev(
+      [&](double W) {
+        return DeformationCorrection(W, W0, Z, R, beta2, betaType, pos, neg);
+      },
+      1., W0, tolerance);
+  // the error of every piece was compared with the direct integral halfway
+  // between its nodes, but pieces stop being bisected when too many are
+  // needed, in which case the table is not used
+  if (!(c.table.GetErrorEstimate() <= tolerance)) {
+    c.table = utilities::PiecewiseChebyshev();
+  }
+  return c;
+}
+
+double bsg::SpectralFunctions::DeformationCorrection(
+    double W, const DeformationCorrectionConstants& c) {
+  if (c.table.Contains(W)) return c.table.GetValue(W);
+  double aPos[7], aNeg[7];
+  std::copy(c.aPos, c.aPos + 7, aPos);
+  std::copy(c.aNeg, c.aNeg + 7, aNeg);
+  return DeformationCorrection(W, c.W0, c.Z, c.R, c.beta2, c.betaType, aPos,
+                               aNeg);
+}
+
 double bsg::SpectralFunctions::L0Correction(double W, int Z, double r, int betaType,
                                        double aPos[], double aNeg[]) {
   double gamma = std::sqrt(1. - std::pow(ALPHA * Z, 2.));
@@ -380,6 +610,27 @@ double bsg::SpectralFunctions::L0Correction(double W, int Z, double r, int betaT
   return (common + specific) * 2. / (1. + gamma);
 }
 
+bsg::SpectralFunctions::L0CorrectionConstants
+bsg::SpectralFunctions::PrepareL0Correction(int Z, double r, int betaType,
+                                            const double aPos[],
+                                            const double aNeg[]) {
+  L0CorrectionConstants c;
+  const double* a = (betaType == BETA_PLUS) ? aPos : aNeg;
+  std::copy(a, a + 7, c.a);
+  c.r = r;
+
+  double gamma = std::sqrt(1. - std::pow(ALPHA * Z, 2.));
+  c.cW = betaType * r * ALPHA * Z * (41. - 26. * gamma) / 15. /
+         (2. * gamma - 1);
+  c.cWm1 = betaType * ALPHA * Z * r * gamma * (17. - 2. * gamma) / 30. /
+           (2. * gamma - 1);
+  c.constant = 1. + 13. / 60. * std::pow(ALPHA * Z, 2) +
+               ((betaType == BETA_PLUS) ? 0.22 : 0.41) * (r - 0.0164) *
+                   std::pow(ALPHA * Z, 4.5);
+  c.norm = 2. / (1. + gamma);
+  return c;
+}
+
 double bsg::SpectralFunctions::UCorrection(double W, int Z, double R, int betaType,
                                       std::string ESShape,
                                       std::vector<double>& v,
@@ -425,6 +676,42 @@ double bsg::SpectralFunctions::UCorrection(double W, int Z, double R, int betaTy
 
   return result;
 }
+
+bsg::SpectralFunctions::UCorrectionConstants
+bsg::SpectralFunctions::PrepareUCorrection(int Z, double R, int betaType,
+                                           std::string ESShape,
+                                           const std::vector<double>& v,
+                                           const std::vector<double>& vp) {
+  UCorrectionConstants c = {};
+  if (ESShape == "Fermi") {
+    c.a0 = -5.6E-5 - betaType * 4.94E-5 * Z + 6.23E-8 * std::pow(Z, 2);
+    c.a1 = 5.17E-6 + betaType * 2.517E-6 * Z + 2.00E-8 * std::pow(Z, 2);
+    c.a2 = -9.17e-8 + betaType * 5.53E-9 * Z + 1.25E-10 * std::pow(Z, 2);
+  }
+
+  double delta1 = 4. / 3. * (vp[0] - v[0]) + 17. / 30. * (vp[1] - v[1]) +
+                  25. / 63. * (vp[2] - v[2]);
+  double delta2 = 2. / 3. * (vp[0] - v[0]) + 7. / 12. * (vp[1] - v[1]) +
+                  11. / 6. * (vp[2] - v[2]);
+  double delta3 = 1. / 3. * (vp[0] * vp[0] - v[0] * v[0]) +
+                  1. / 15. * (vp[1] * vp[1] - v[1] * v[1]) +
+                  1. / 35. * (vp[2] * vp[2] - v[2] * v[2]) +
+                  1. / 6. * (vp[1] * vp[0] - v[1] * v[0]) +
+                  1. / 9. * (vp[2] * vp[0] - v[2] * v[0]) +
+                  1. / 20. * (vp[2] * vp[1] - v[2] * v[1]) +
+                  1. / 5. * (vp[1] - v[1]) + 1. / 7. * (vp[2] - v[2]);
+  double delta4 = 4. / 3. * (vp[0] - v[0]) + 4. / 5. * (vp[1] - v[1]) +
+                  4. / 7. * (vp[2] - v[2]);
+
+  double gamma = std::sqrt(1. - (ALPHA * Z) * (ALPHA * Z));
+
+  c.c0 = 1. + (ALPHA * Z) * (ALPHA * Z) * delta3;
+  c.c1 = betaType * ALPHA * Z * R * delta1;
+  c.cm1 = betaType * gamma * ALPHA * Z * R * delta2;
+  c.c2 = R * R * delta4;
+  return c;
+}
+
 double bsg::SpectralFunctions::QCorrection(double W, double W0, int Z, int A,
                                       int betaType, int decayType,
                                       double mixingRatio) {
@@ -444,6 +731,28 @@ double bsg::SpectralFunctions::QCorrection(double W, double W0, int Z, int A,
   return 1. - betaType * M_PI * ALPHA * Z / M / p * (1. + a * (W0 - W) / 3. / M);
 }
 
+bsg::SpectralFunctions::QCorrectionConstants
+bsg::SpectralFunctions::PrepareQCorrection(double W0, int Z, int A,
+                                           int betaType, int decayType,
+                                           double mixingRatio) {
+  double a = 0;
+
+  if (decayType == FERMI)
+    a = 1.;
+  else if (decayType == GAMOW_TELLER)
+    a = -1. / 3.;
+  else if (mixingRatio > 0.)
+    a = (1. - std::pow(mixingRatio, 2.) / 3.) / (1. + std::pow(mixingRatio, 2));
+
+  double M = A * (PROTON_MASS_KEV + NEUTRON_MASS_KEV) / 2. / ELECTRON_MASS_KEV;
+
+  QCorrectionConstants c;
+  c.W0 = W0;
+  c.c = betaType * M_PI * ALPHA * Z / M;
+  c.d = a / 3. / M;
+  return c;
+}
+
 double bsg::SpectralFunctions::RadiativeCorrection(double W, double W0, int Z,
                                               double R, int betaType, double gA,
                                               double gM) {
@@ -503,6 +812,81 @@ double bsg::SpectralFunctions::RadiativeCorrection(double W, double W0, int Z,
   return (1 + O1corr) * (L + O2corr + O3corr);
 }
 
+bsg::SpectralFunctions::RadiativeCorrectionConstants
+bsg::SpectralFunctions::PrepareRadiativeCorrection(double W0, int Z, double R,
+                                                   int betaType, double gA,
+                                                   double gM) {
+  RadiativeCorrectionConstants c;
+  c.W0 = W0;
+
+  // 1st order, based on the 5th Wilkinson article
+  c.g0 = 3. * std::log(PROTON_MASS_KEV / ELECTRON_MASS_KEV) - 0.75 -
+         3. * std::log(PROTON_MASS_KEV / ELECTRON_MASS_KEV / 2. / W0);
+
+  double L =
+      1.026725 * std::pow(1. - 2. * ALPHA / 3. / M_PI * std::log(2. * W0), 9. / 4.);
+
+  // 2nd order, only d14 depends on W through -5/3 ln(2W)
+  double d1f, d2, d3, d14;
+  double lambda = std::sqrt(10) / R;
+  double lambdaOverM =
+      lambda / NUCLEON_MASS_KEV * ELECTRON_MASS_KEV;  // this is dimensionless
+
+  d14 = std::log(PROTON_MASS_KEV / ELECTRON_MASS_KEV) + 43. / 18.;
+
+  d1f = std::log(lambdaOverM) - EULER_MASCHERONI_CONSTANT + 4. / 3. -
+        std::log(std::sqrt(10.0)) -
+        3.0 / M_PI / std::sqrt(10.0) * lambdaOverM * (0.5 + EULER_MASCHERONI_CONSTANT +
+                                        std::log(std::sqrt(10) / lambdaOverM));
+
+  d2 = 3.0 / 2.0 / M_PI / std::sqrt(10.0) * lambdaOverM *
+       (1. - M_PI / 2. / std::sqrt(10) * lambdaOverM);
+
+  d3 = 3.0 * gA * gM / M_PI / std::sqrt(10.0) * lambdaOverM *
+       (EULER_MASCHERONI_CONSTANT - 1. + std::log(std::sqrt(10) / lambdaOverM) +
+        M_PI / 4 / std::sqrt(10) * lambdaOverM);
+
+  double O2 = ALPHA * ALPHA * Z;
+
+  // 3rd order, written as a polynomial in ln(2W) using
+  // ln(lambda/W) = ln(2 lambda) - ln(2W) and ln(2RW) = ln(R) + ln(2W)
+  double a = 0.5697;
+  double b =
+      4. / 3. / M_PI * (11. / 4. - EULER_MASCHERONI_CONSTANT - M_PI * M_PI / 6);
+  double O3 = std::pow(ALPHA, 3) * std::pow(Z, 2);
+
+  double O3const = a * std::log(2. * lambda) - b * 5. / 6. +
+                   4. / M_PI / 3. *
+                       (0.5 * std::pow(std::log(R), 2.) + 5. / 3. * std::log(R)) -
+                   0.649 * std::log(2 * W0);
+
+  c.K = L + O2 * (d14 + d1f + d2 + d3) + O3 * O3const;
+  c.m1 = -5. / 3. * O2 + O3 * (-a + b + 4. / M_PI / 3. * 5. / 3.);
+  c.m2 = -O3 * 4. / M_PI / 3. * 0.5;
+  return c;
+}
+
+double bsg::SpectralFunctions::RadiativeCorrection(
+    double W, const RadiativeCorrectionConstants& c) {
+  double W0 = c.W0;
+  double beta = std::sqrt(1.0 - 1.0 / W / W);
+  double atanhBeta = std::atanh(beta);
+
+  double g = c.g0 +
+             4. * (atanhBeta / beta - 1.) *
+                 ((W0 - W) / 3. / W - 1.5 + std::log(2 * (W0 - W)));
+  g += 4.0 / beta * Spence(2. * beta / (1. + beta)) +
+       atanhBeta / beta *
+           (2. * (1. + beta * beta) + (W0 - W) * (W0 - W) / 6. / W / W -
+            4. * atanhBeta);
+
+  double O1corr = ALPHA / 2. / M_PI * g;
+
+  double lnW = std::log(2 * W);
+
+  return (1 + O1corr) * (c.K + (c.m1 + c.m2 * lnW) * lnW);
+}
+
 double bsg::SpectralFunctions::NeutrinoRadiativeCorrection(double Wv) {
   double h = 0.;
   double pv = std::sqrt(Wv * Wv - 1);
@@ -550,11 +934,53 @@ double bsg::SpectralFunctions::RecoilCorrection(double W, double W0, int A,
   return 1;
 }
 
+bsg::SpectralFunctions::RecoilCorrectionConstants
+bsg::SpectralFunctions::PrepareRecoilCorrection(double W0, int A,
+                                                int decayType,
+                                                double mixingRatio) {
+  double Vr0, Vr1, Vr2, Vr3;
+  double Ar0, Ar1, Ar2, Ar3;
+  double M = A * (PROTON_MASS_KEV + NEUTRON_MASS_KEV) / 2. /
+             ELECTRON_MASS_KEV;  // in units of electron mass
+  double M2 = sqr(M);
+
+  Ar0 = -2. * W0 / 3. / M - W0 * W0 / 6. / M2 - 77. / 18. / M2;
+  Ar1 = -2. / 3. / M + 7. * W0 / 9. / M2;
+  Ar2 = 10. / 3. / M - 28. * W0 / 9. / M2;
+  Ar3 = 88. / 9. / M2;
+
+  Vr0 = W0 * W0 / 2. / M2 - 11. / 6. / M2;
+  Vr1 = W0 / 3. / M2;
+  Vr2 = 2. / M - 4. * W0 / 3. / M2;
+  Vr3 = 16. / 3. / M2;
+
+  double fV = 0., fA = 0.;
+  if (decayType == FERMI) {
+    fV = 1.;
+  } else if (decayType == GAMOW_TELLER) {
+    fA = 1.;
+  } else if (mixingRatio > 0) {
+    fV = 1. / (1 + std::pow(mixingRatio, 2));
+    fA = 1. / (1 + 1. / std::pow(mixingRatio, 2));
+  } else {
+    cout << "Mixing ratio badly defined. Returning 1." << endl;
+  }
+
+  RecoilCorrectionConstants c;
+  c.c0 = fV * Vr0 + fA * Ar0;
+  c.cm1 = fV * Vr1 + fA * Ar1;
+  c.c1 = fV * Vr2 + fA * Ar2;
+  c.c2 = fV * Vr3 + fA * Ar3;
+  return c;
+}
+
 double bsg::SpectralFunctions::AtomicScreeningCorrection(double W, int Z,
                                                     int betaType) {
   std::vector<double> Aby, Bby;
 
   screening::PotParam(Z - 1 * betaType, Aby, Bby);
+  // a bare nucleus has no atomic electrons to screen it
+  if (Aby.empty()) return 1.;
 
   double l = 2 * (Aby[0] * Bby[0] + Aby[1] * Bby[1] + Aby[2] * Bby[2]);
 
@@ -599,7 +1025,63 @@ double bsg::SpectralFunctions::AtomicScreeningCorrection(double W, int Z,
   return first * second * third * fourth * fifth;
 }
 
-double bsg::SpectralFunctions::AtomicExchangeCorrection(double W, double exPars[9]) {
+bsg::SpectralFunctions::AtomicScreeningCorrectionConstants
+bsg::SpectralFunctions::PrepareAtomicScreeningCorrection(int Z, int betaType) {
+  screening::PotentialParameters pot =
+      screening::GetPotentialParameters(Z - 1 * betaType);
+
+  AtomicScreeningCorrectionConstants c;
+  c.l = 2 * (pot.A[0] * pot.B[0] + pot.A[1] * pot.B[1] + pot.A[2] * pot.B[2]);
+  c.gamma = std::sqrt(1. - pow(ALPHA * Z, 2.));
+  c.alphaZ = betaType * ALPHA * Z;
+  c.V0 = betaType * 0.5 * ALPHA * (Z - betaType) * c.l;
+  return c;
+}
+
+double bsg::SpectralFunctions::AtomicScreeningCorrection(
+    double W, const AtomicScreeningCorrectionConstants& c) {
+  // a bare nucleus has no atomic electrons to screen it
+  if (c.l == 0.) return 1.;
+
+  double l = c.l;
+  double gamma = c.gamma;
+
+  double p = std::sqrt(W * W - 1);
+
+  double Wt = W - c.V0;
+
+  std::complex<double> pt;
+
+  pt = 0.5 * p +
+       0.5 * std::sqrt(std::complex<double>(p * p -
+                                            2 * c.alphaZ * Wt * l));
+
+  double y = c.alphaZ * W / p;
+  std::complex<double> yt = c.alphaZ * Wt / pt;
+
+  gsl_sf_result magn;
+  gsl_sf_result phase;
+  gsl_sf_lngamma_complex_e(gamma, y, &magn, &phase);
+
+  gsl_sf_result magnT;
+  gsl_sf_result phaseT;
+  gsl_sf_lngamma_complex_e(gamma - yt.imag(), yt.real(), &magnT, &phaseT);
+  // now we have what we wAt in magn.val
+
+  double first = Wt / W;
+  double second = std::exp(2 * (magnT.val - magn.val));
+
+  gsl_sf_lngamma_complex_e(gamma - 2 * pt.imag() / l, 2 * pt.real() / l, &magnT,
+                           &phaseT);
+  gsl_sf_lngamma_complex_e(1, 2 * p / l, &magn, &phase);
+  double third = std::exp(2 * (magnT.val - magn.val));
+  double fourth = std::exp(-M_PI * y);
+  double fifth = std::pow(2 * p / l, 2 * (1 - gamma));
+
+  return first * second * third * fourth * fifth;
+}
+
+double bsg::SpectralFunctions::AtomicExchangeCorrection(double W, const double exPars[9]) {
   double E = W - 1;
 
   return 1 + exPars[0] / E + exPars[1] / E / E +
@@ -631,3 +1113,37 @@ double bsg::SpectralFunctions::AtomicMismatchCorrection(double W, double W0, int
 
   return 1 - 2 / (W0 - W) * (0.5 * dBdZ2 + 2 * (C0 + C1));
 }
+
+bsg::SpectralFunctions::AtomicMismatchCorrectionConstants
+bsg::SpectralFunctions::PrepareAtomicMismatchCorrection(double W0, int Z,
+                                                        int A, int betaType) {
+  AtomicMismatchCorrectionConstants c;
+  c.W0 = W0;
+  c.dBdZ2 = (44.200 * std::pow(Z - betaType, 0.41) +
+             2.3196E-7 * std::pow(Z - betaType, 4.45)) /
+            ELECTRON_MASS_KEV / 1000.;
+
+  double K = -0.872 + 1.270 * std::pow(Z, 0.097) + 9.062E-11 * std::pow(Z, 4.5);
+  c.lK = 1.83E-3 * K * Z;
+  double M = A * (PROTON_MASS_KEV + NEUTRON_MASS_KEV) / 2. / ELECTRON_MASS_KEV;
+  // assume as A average the recoil velocity at half-momentum trAsfer ~
+  // std::sqrt(W0^2-1)/2
+  c.vR = std::sqrt(1 - M * M / (M * M + (W0 * W0 - 1) / 4.));
+  c.alphaZ = ALPHA * Z;
+  return c;
+}
+
+double bsg::SpectralFunctions::AtomicMismatchCorrection(
+    double W, const AtomicMismatchCorrectionConstants& c) {
+  double vp = std::sqrt(1 - 1 / W / W);
+  double l = c.lK / vp;
+
+  double psi2 = 1 + 2 * ALPHA / vp * (std::atan(1 / l) - l / 2 / (1 + l * l));
+
+  double C0 = -ALPHA * c.alphaZ * ALPHA / vp * l / (1 + l * l) / psi2;
+
+  double C1 = 2 * ALPHA * c.alphaZ * c.vR / vp *
+              ((0.5 + l * l) / (1 + l * l) - l * std::atan(1 / l)) / psi2;
+
+  return 1 - 2 / (c.W0 - W) * (0.5 * c.dBdZ2 + 2 * (C0 + C1));
+}
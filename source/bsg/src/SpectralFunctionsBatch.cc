@@ -0,0 +1,127 @@
+#include "SpectralFunctions.h"
+
+#include <algorithm>
+#include <cmath>
+
+/**
+ * The batch kernels are plain loops over the scalar functions, without
+ * intrinsics, so that any vectorisation is left to the compiler's
+ * auto-vectoriser. All but the atomic exchange correction, whose loop calls
+ * exp, pow and sin, vectorise with SSE2 already. Their cost is dominated by
+ * the divisions and square roots rather than by the vector width, so only
+ * the kernels for which bsg_bench measures a gain of at least 10% are also
+ * compiled for AVX-512 and AVX2, with the best version for the running CPU
+ * picked at load time. This file is compiled with -O3 -fno-math-errno
+ * -ffp-contract=off (see CMakeLists.txt) so that std::sqrt can vectorise
+ * without fused multiply-adds changing the results with respect to the
+ * scalar code.
+ */
+#if defined(BSG_ENABLE_SIMD) && defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__)
+#define BSG_SIMD_CLONES __attribute__((target_clones("avx512f", "avx2", "default")))
+#else
+#define BSG_SIMD_CLONES
+#endif
+
+void bsg::SpectralFunctions::PhaseSpace(const double* W, double* result,
+                                        std::size_t n, double W0,
+                                        int motherSpinParity,
+                                        int daughterSpinParity) {
+  for (std::size_t i = 0; i < n; i++) {
+    double Wi = W[i];
+    double q = W0 - Wi;
+    result[i] = std::sqrt(Wi * Wi - 1.) * Wi * (q * q);
+  }
+}
+
+/**
+ * The prepared constants are copied to the stack so that the compiler knows
+ * they cannot alias the output arrays.
+ */
+void bsg::SpectralFunctions::CCorrectionComponents(
+    const double* W, double* cShape, double* cNS, std::size_t n,
+    const CCorrectionConstants& constants) {
+  const CCorrectionConstants c = constants;
+  for (std::size_t i = 0; i < n; i++) {
+    std::tie(cShape[i], cNS[i]) = CCorrectionComponents(W[i], c);
+  }
+}
+
+void bsg::SpectralFunctions::CCorrection(const double* W, double* result,
+                                         std::size_t n,
+                                         const CCorrectionConstants& constants,
+                                         const CICorrectionConstants& ciConstants) {
+  const CCorrectionConstants c = constants;
+  const CICorrectionConstants ci = ciConstants;
+  for (std::size_t i = 0; i < n; i++) {
+    result[i] = CCorrection(W[i], c, ci);
+  }
+}
+
+void bsg::SpectralFunctions::RelativisticCorrection(
+    const double* W, double* result, std::size_t n,
+    const RelativisticCorrectionConstants& constants) {
+  const RelativisticCorrectionConstants c = constants;
+  // the correction is 1 unless the transition is Fermi, which is decided
+  // outside the loop so that it also vectorises without AVX-512 masking
+  if (!c.fermi) {
+    std::fill(result, result + n, 1.);
+    return;
+  }
+  for (std::size_t i = 0; i < n; i++) {
+    result[i] = RelativisticCorrection(W[i], c);
+  }
+}
+
+BSG_SIMD_CLONES
+void bsg::SpectralFunctions::L0Correction(const double* W, double* result,
+                                          std::size_t n,
+                                          const L0CorrectionConstants& constants) {
+  const L0CorrectionConstants c = constants;
+  for (std::size_t i = 0; i < n; i++) {
+    result[i] = L0Correction(W[i], c);
+  }
+}
+
+BSG_SIMD_CLONES
+void bsg::SpectralFunctions::UCorrection(const double* W, double* result,
+                                         std::size_t n,
+                                         const UCorrectionConstants& constants) {
+  const UCorrectionConstants c = constants;
+  for (std::size_t i = 0; i < n; i++) {
+    result[i] = UCorrection(W[i], c);
+  }
+}
+
+void bsg::SpectralFunctions::QCorrection(const double* W, double* result,
+                                         std::size_t n,
+                                         const QCorrectionConstants& constants) {
+  const QCorrectionConstants c = constants;
+  for (std::size_t i = 0; i < n; i++) {
+    result[i] = QCorrection(W[i], c);
+  }
+}
+
+void bsg::SpectralFunctions::RecoilCorrection(
+    const double* W, double* result, std::size_t n,
+    const RecoilCorrectionConstants& constants) {
+  const RecoilCorrectionConstants c = constants;
+  for (std::size_t i = 0; i < n; i++) {
+    result[i] = RecoilCorrection(W[i], c);
+  }
+}
+
+void bsg::SpectralFunctions::AtomicExchangeCorrection(const double* W,
+                                                      double* result,
+                                                      std::size_t n,
+                                                      const double exPars[9]) {
+  for (std::size_t i = 0; i < n; i++) {
+    double E = W[i] - 1;
+    result[i] = 1 + exPars[0] / E + exPars[1] / E / E;
+  }
+  for (std::size_t i = 0; i < n; i++) {
+    double E = W[i] - 1;
+    result[i] += exPars[2] * std::exp(-exPars[3] * E) +
+                 exPars[4] * sin(std::pow(W[i] - exPars[6], exPars[5]) + exPars[7]) /
+                     std::pow(W[i], exPars[8]);
+  }
+}
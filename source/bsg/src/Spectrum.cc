@@ -0,0 +1,22 @@
+#include "Spectrum.h"
+#include "Utilities.h"
+
+#include <stdexcept>
+
+bsg::Spectrum::Spectrum(std::vector<double> W, std::vector<double> electron,
+                        std::vector<double> neutrino)
+    : W(std::move(W)), electron(std::move(electron)),
+      neutrino(std::move(neutrino)) {
+  if (this->electron.size() != this->W.size() ||
+      this->neutrino.size() != this->W.size()) {
+    throw std::invalid_argument("Spectrum columns must have the same length");
+  }
+}
+
+double bsg::Spectrum::Integrate(int moment) const {
+  return utilities::Simpson(W.data(), electron.data(), W.size(), moment);
+}
+
+double bsg::Spectrum::CalculateMeanEnergy() const {
+  return Integrate(1) / Integrate(0);
+}
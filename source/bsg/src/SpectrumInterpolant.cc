@@ -0,0 +1,99 @@
+#include "SpectrumInterpolant.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <tuple>
+
+/**
+ * Find the range around the middle of [a, b] in which a rate is at least
+ * 1e-30 of its value in the middle. Beyond it, e.g. where the Fermi function
+ * of a positron vanishes like exp(-2 pi |eta|), relative accuracy is
+ * meaningless and the logarithm is too steep to interpolate economically.
+ */
+static std::tuple<double, double> FindFitRange(
+    const std::function<double(double)>& logRate, double a, double b) {
+  double mid = (a + b) / 2.;
+  double threshold = logRate(mid) - 30. * std::log(10.);
+  if (!std::isfinite(threshold)) return std::make_tuple(a, b);
+  auto edge = [&](double inside, double outside) {
+    if (logRate(outside) >= threshold) return outside;
+    for (int i = 0; i < 40; i++) {
+      double m = (inside + outside) / 2.;
+      if (logRate(m) >= threshold) {
+        inside = m;
+      } else {
+        outside = m;
+      }
+    }
+    return inside;
+  };
+  return std::make_tuple(edge(mid, a), edge(mid, b));
+}
+
+bsg::SpectrumInterpolant::SpectrumInterpolant(const CorrectionPlan& plan,
+                                              double beginW, double endW,
+                                              double tolerance, int nThreads)
+    : plan(&plan), tolerance(tolerance) {
+  /**
+   * Within about 50 eV of W = 1 the rounding of p = sqrt(W^2 - 1) in the
+   * Coulomb functions exceeds 1e-9 of their logarithm for heavy nuclei, so
+   * that no piece would converge there. The same holds for the neutrino at
+   * W0.
+   */
+  double W0 = plan.GetEndpoint();
+  double margin = std::min(1e-4, (W0 - 1.) / 4.);
+  double a = std::max(beginW, 1. + margin);
+  double b = std::min(endW, W0 - margin);
+  if (!(a < b)) return;
+
+  std::atomic<std::size_t> count(0);
+  std::function<double(double)> logRate[2] = {
+      [&](double W) { count++; return std::log(std::get<0>(plan.Evaluate(W))); },
+      [&](double W) { count++; return std::log(std::get<1>(plan.Evaluate(W))); }};
+  utilities::PiecewiseChebyshev* fits[2] = {&logElectron, &logNeutrino};
+
+  // a vanishing rate gives a non-finite logarithm, which fails the pieces around it
+  utilities::ParallelFor(2, nThreads, 1, [&](std::size_t i) {
+    double lo, hi;
+    std::tie(lo, hi) = FindFitRange(logRate[i], a, b);
+    *fits[i] = utilities::PiecewiseChebyshev(logRate[i], lo, hi, tolerance, 12, 512);
+  });
+  evaluations = count;
+}
+
+std::size_t bsg::SpectrumInterpolant::Evaluate(const std::vector<double>& W,
+                                               std::vector<double>& electron,
+                                               std::vector<double>& neutrino,
+                                               int nThreads) const {
+  if (logElectron.GetNumberOfPieces() == 0 || logNeutrino.GetNumberOfPieces() == 0) {
+    plan->Evaluate(W, electron, neutrino, nThreads);
+    return W.size();
+  }
+
+  std::size_t n = W.size();
+  electron.resize(n);
+  neutrino.resize(n);
+  std::atomic<std::size_t> direct(0);
+  const std::size_t blockSize = 4096;
+  utilities::ParallelFor((n + blockSize - 1) / blockSize, nThreads, 1, [&](std::size_t b) {
+    std::size_t begin = b * blockSize;
+    std::size_t m = std::min(blockSize, n - begin);
+    std::vector<double> electronError(m), neutrinoError(m);
+    logElectron.GetValues(&W[begin], &electron[begin], m, electronError.data());
+    logNeutrino.GetValues(&W[begin], &neutrino[begin], m, neutrinoError.data());
+    for (std::size_t i = begin; i < begin + m; i++) {
+      if (logElectron.Contains(W[i]) && logNeutrino.Contains(W[i]) &&
+          electronError[i - begin] <= tolerance && neutrinoError[i - begin] <= tolerance) {
+        electron[i] = std::exp(electron[i]);
+        neutrino[i] = std::exp(neutrino[i]);
+      } else {
+        // next to W = 1 and W0, or to a point where a correction is not smooth
+        std::tie(electron[i], neutrino[i]) = plan->Evaluate(W[i]);
+        direct++;
+      }
+    }
+  });
+  return direct;
+}
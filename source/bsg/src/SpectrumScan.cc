@@ -0,0 +1,50 @@
+#include "SpectrumScan.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+bsg::SpectrumScan::SpectrumScan(std::string parameter, Spectrum lower,
+                                Spectrum upper)
+    : parameter(parameter), lower(std::move(lower)), upper(std::move(upper)) {
+  if (this->lower.GetSize() != this->upper.GetSize()) {
+    throw std::invalid_argument("Scanned spectra must share their grid");
+  }
+  for (int k = 0; k < 3; k++) {
+    lowerMoments[k] = this->lower.Integrate(k);
+    upperMoments[k] = this->upper.Integrate(k);
+  }
+}
+
+void bsg::SpectrumScan::Evaluate(double x, Span<double> electron,
+                                 Span<double> neutrino) const {
+  std::size_t n = lower.GetSize();
+  if (electron.size() != n || neutrino.size() != n) {
+    throw std::invalid_argument("Evaluate requires views of the grid size");
+  }
+  Span<const double> e0 = lower.GetElectron(), e1 = upper.GetElectron();
+  Span<const double> v0 = lower.GetNeutrino(), v1 = upper.GetNeutrino();
+  for (std::size_t i = 0; i < n; i++) {
+    electron[i] = std::max(0., (1. - x) * e0[i] + x * e1[i]);
+    neutrino[i] = std::max(0., (1. - x) * v0[i] + x * v1[i]);
+  }
+}
+
+bsg::Spectrum bsg::SpectrumScan::GetSpectrum(double x) const {
+  Span<const double> W = lower.GetW();
+  std::vector<double> electron(W.size()), neutrino(W.size());
+  Evaluate(x, electron, neutrino);
+  return Spectrum(std::vector<double>(W.begin(), W.end()), std::move(electron),
+                  std::move(neutrino));
+}
+
+double bsg::SpectrumScan::Integrate(double x, int moment) const {
+  if (moment < 0 || moment > 2) {
+    return GetSpectrum(x).Integrate(moment);
+  }
+  return (1. - x) * lowerMoments[moment] + x * upperMoments[moment];
+}
+
+double bsg::SpectrumScan::CalculateMeanEnergy(double x) const {
+  return Integrate(x, 1) / Integrate(x, 0);
+}
@@ -1,5 +1,10 @@
 #include "Utilities.h"
 
+#include <cmath>
+#include <mutex>
+
+#include "gsl/gsl_errno.h"
+
 bsg::utilities::Lagrange::Lagrange(double* x, double* y) {
   xC[0] = x[0];
   xC[1] = x[1];
@@ -19,3 +24,98 @@ double bsg::utilities::Lagrange::GetValue(double x) {
 
   return first + second + third;
 }
+
+/**
+ * Evaluate a Chebyshev series on [-1, 1] using Clenshaw's recurrence
+ */
+static double ChebyshevSeries(const std::vector<double>& c, double t) {
+  double b1 = 0., b2 = 0.;
+  for (size_t j = c.size() - 1; j > 0; j--) {
+    double b0 = 2. * t * b1 - b2 + c[j];
+    b2 = b1;
+    b1 = b0;
+  }
+  return t * b1 - b2 + c[0];
+}
+
+bsg::utilities::PiecewiseChebyshev::PiecewiseChebyshev(
+    std::function<double(double)> f, double a, double b, double tolerance,
+    int degree, int maxPieces) {
+  Fit(f, a, b, tolerance, std::max(2, degree), std::max(1, maxPieces));
+}
+
+void bsg::utilities::PiecewiseChebyshev::Fit(
+    const std::function<double(double)>& f, double a, double b,
+    double tolerance, int degree, int maxPieces) {
+  int nNodes = degree + 1;
+  double mid = (a + b) / 2.;
+  double half = (b - a) / 2.;
+
+  std::vector<double> values(nNodes);
+  for (int k = 0; k < nNodes; k++) {
+    values[k] = f(mid + half * std::cos(M_PI * (k + 0.5) / nNodes));
+  }
+  Piece piece = {a, b, std::vector<double>(nNodes), 0.};
+  for (int j = 0; j < nNodes; j++) {
+    double sum = 0.;
+    for (int k = 0; k < nNodes; k++) {
+      sum += values[k] * std::cos(M_PI * j * (k + 0.5) / nNodes);
+    }
+    piece.c[j] = 2. / nNodes * sum;
+  }
+  piece.c[0] /= 2.;
+
+  double error = std::abs(piece.c[degree - 1]) + std::abs(piece.c[degree]);
+  for (int k = 0; k < nNodes - 1 && error <= tolerance; k++) {
+    double t = std::cos(M_PI * (k + 1.) / nNodes);
+    error = std::max(error,
+                     std::abs(ChebyshevSeries(piece.c, t) - f(mid + half * t)));
+  }
+
+  // a NaN error is treated as a failure as well, and pieces around a
+  // singular point are not bisected below a relative width of 1e-9
+  int remaining = maxPieces - (int)pieces.size();
+  if (!(error <= tolerance) && remaining >= 2 && half > 1e-9 * std::abs(mid)) {
+    Fit(f, a, mid, tolerance, degree, maxPieces - 1);
+    Fit(f, mid, b, tolerance, degree, maxPieces);
+    return;
+  }
+  maxError = (error <= maxError) ? maxError : error;
+  piece.error = error;
+  pieces.push_back(piece);
+}
+
+double bsg::utilities::PiecewiseChebyshev::GetValue(double x) const {
+  auto it = std::lower_bound(
+      pieces.begin(), pieces.end(), x,
+      [](const Piece& piece, double value) { return piece.b < value; });
+  if (it == pieces.end()) --it;
+  return ChebyshevSeries(it->c, (2. * x - it->a - it->b) / (it->b - it->a));
+}
+
+void bsg::utilities::PiecewiseChebyshev::GetValues(const double* x, double* y,
+                                                  size_t n,
+                                                  double* error) const {
+  size_t j = 0;
+  for (size_t i = 0; i < n; i++) {
+    while (j + 1 < pieces.size() && x[i] > pieces[j].b) j++;
+    while (j > 0 && x[i] < pieces[j].a) j--;
+    const Piece& piece = pieces[j];
+    y[i] = ChebyshevSeries(piece.c, (2. * x[i] - piece.a - piece.b) / (piece.b - piece.a));
+    if (error) error[i] = piece.error;
+  }
+}
+
+gsl_integration_workspace* bsg::utilities::GetIntegrationWorkspace(int depth) {
+  struct Workspace {
+    gsl_integration_workspace* w = gsl_integration_workspace_alloc(1000);
+    ~Workspace() { gsl_integration_workspace_free(w); }
+  };
+  static thread_local Workspace workspaces[2];
+  return workspaces[depth].w;
+}
+
+void bsg::utilities::TurnOffGSLErrorHandler() {
+  static std::once_flag flag;
+  std::call_once(flag, []() { gsl_set_error_handler_off(); });
+}
@@ -1,15 +1,160 @@
 #include "Generator.h"
 #include "BSGOptionContainer.h"
+#include "GeneratorConfig.h"
+#include "SpectrumServer.h"
+#include "Constants.h"
+#include "Utilities.h"
 #include <iostream>
+#include <fstream>
 #include <chrono>
+#include <mutex>
 #include <string>
+#include <vector>
+#include <glob.h>
+
+#include "spdlog/fmt/fmt.h"
+
+/**
+ * Calculate the spectrum, only its integrals, a parameter scan, sampled
+ * energies or the propagated uncertainties, depending on the options of the
+ * Generator
+ */
+void Run(bsg::Generator* gen) {
+  if (gen->GetConfig().Exists("scan")) {
+    gen->CalculateScan(gen->GetConfig().Get<std::string>("scan"));
+  } else if (gen->GetConfig().Get<std::size_t>("Sampler.Events") > 0) {
+    gen->GenerateEvents();
+  } else if (gen->GetConfig().Get<int>("MC.Samples") > 0) {
+    gen->CalculateUncertainties();
+  } else if (gen->GetConfig().Get<bool>("Spectrum.IntegralOnly")) {
+    gen->CalculateIntegrals();
+  } else {
+    gen->CalculateSpectrum();
+  }
+}
+
+/**
+ * Get the input files of a batch, given either as a wildcard pattern or as a
+ * file listing one input file per line. Empty lines and lines starting with #
+ * are skipped.
+ */
+std::vector<std::string> GetBatchInputs(std::string batch) {
+  std::vector<std::string> inputs;
+  if (batch.find_first_of("*?[") != std::string::npos) {
+    glob_t matches;
+    if (glob(batch.c_str(), 0, NULL, &matches) == 0) {
+      for (size_t i = 0; i < matches.gl_pathc; i++) inputs.push_back(matches.gl_pathv[i]);
+    }
+    globfree(&matches);
+  } else {
+    std::ifstream listStream(batch.c_str());
+    std::string line;
+    while (getline(listStream, line)) {
+      line.erase(line.find_last_not_of(" \t\r") + 1);
+      if (!line.empty() && line[0] != '#') inputs.push_back(line);
+    }
+  }
+  return inputs;
+}
+
+/**
+ * Calculate all transitions of a batch on a number of worker threads.
+ * Every transition starts from the command line and configuration options and
+ * adds the transition information of its input file to its own
+ * GeneratorConfig.
+ * Results of transition i are written to <output>_<name of input i>, and one
+ * line per transition is added to <output>_summary.txt.
+ * Constructing a Generator fits the charge distribution, with ROOT in ROOT
+ * builds, and may run the nuclear structure calculation, neither of which is
+ * thread safe, so Generators are constructed one at a time while the spectra
+ * are calculated concurrently. b/Ac and d/Ac are only reported when the C
+ * correction, the only one using them, is turned on, and log f(t) and <E>
+ * only when a spectrum or its integrals were calculated.
+ */
+int RunBatch() {
+  std::vector<std::string> inputs = GetBatchInputs(GetBSGOpt(std::string, batch));
+  if (inputs.empty()) {
+    std::cerr << "BSG ERROR: No input files found for batch " << GetBSGOpt(std::string, batch) << std::endl;
+    return 1;
+  }
+  std::string output = GetBSGOpt(std::string, output);
+  int nThreads = bsg::utilities::GetThreadCount(GetBSGOpt(int, jobs));
+
+  bsg::GeneratorConfig baseConfig = bsg::GeneratorConfig::FromOptions();
+
+  std::vector<std::string> summary(inputs.size());
+  std::mutex initMutex;
+  auto start = std::chrono::steady_clock::now();
+
+  bsg::utilities::ParallelFor(inputs.size(), nThreads, 1, [&](size_t i) {
+    std::string name = inputs[i].substr(inputs[i].find_last_of('/') + 1);
+    name = output + "_" + name.substr(0, name.find_last_of('.'));
+
+    bsg::GeneratorConfig config = baseConfig;
+    if (!config.ReadInput(inputs[i])) {
+      std::cerr << "BSG ERROR: Input file " << inputs[i] << " cannot be found." << std::endl;
+      summary[i] = fmt::format("{:<40}\tfailed: input file not found", inputs[i]);
+      return;
+    }
+    config.Set("output", name);
+
+    try {
+      std::unique_ptr<bsg::Generator> gen;
+      {
+        std::lock_guard<std::mutex> lock(initMutex);
+        gen.reset(new bsg::Generator(config));
+      }
+      Run(gen.get());
+      double halflife = config.Exists("Transition.PartialHalflife") ? config.Get<double>("Transition.PartialHalflife") : 1.;
+      // with the C correction turned on the form factors were calculated
+      // during construction
+      std::string bAc = "-", dAc = "-";
+      if (gen->GetCorrectionPlan().IsEnabled(bsg::C_CORRECTION)) {
+        bAc = fmt::format("{:.4f}", gen->GetWeakMagnetism());
+        dAc = fmt::format("{:.4f}", gen->GetInducedTensor());
+      }
+      // scans and uncertainty calculations leave no spectrum behind
+      std::string logFt = "-", meanEnergy = "-";
+      if (gen->HasSpectrum()) {
+        logFt = fmt::format("{:.6f}", gen->CalculateLogFtValue(halflife));
+        meanEnergy = fmt::format("{:.4f}", (gen->CalculateMeanEnergy() - 1.) * bsg::ELECTRON_MASS_KEV);
+      }
+      summary[i] = fmt::format("{:<40}\t{:<12}\t{:<12}\t{:<12}\t{:<12}", inputs[i], logFt, meanEnergy, bAc,
+                               dAc);
+    } catch (std::exception& e) {
+      std::cerr << "BSG ERROR: Calculation of " << inputs[i] << " failed: " << e.what() << std::endl;
+      summary[i] = fmt::format("{:<40}\tfailed: {}", inputs[i], e.what());
+    }
+  });
+
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+  std::ofstream summaryStream((output + "_summary.txt").c_str());
+  summaryStream << fmt::format("{:<40}\t{:<12}\t{:<12}\t{:<12}\t{:<12}\n", "Input", "log f(t)", "<E> [keV]", "b/Ac", "d/Ac");
+  for (const std::string& line : summary) summaryStream << line << "\n";
+
+  std::cout << "Calculated " << inputs.size() << " transitions on " << nThreads << " thread(s) in "
+            << elapsed.count() / 1000. << " s (" << inputs.size() * 1000. / std::max(1., (double)elapsed.count())
+            << " transitions/s)" << std::endl;
+  return 0;
+}
 
 int main(int argc, char** argv) {
   bsg::BSGOptionContainer::GetInstance(argc, argv);
 
+  if (BSGOptExists(batch)) {
+    return RunBatch();
+  }
+
+  if (BSGOptExists(serve)) {
+    bsg::SpectrumServer server(GetBSGOpt(std::string, serve), bsg::GeneratorConfig::FromOptions(),
+                               bsg::utilities::GetThreadCount(GetBSGOpt(int, jobs)));
+    return server.Run();
+  }
+
   if (BSGOptExists(input)) {
     bsg::Generator* gen = new bsg::Generator();
-    gen->CalculateSpectrum();
+    Run(gen);
     delete gen;
   }
 
@@ -0,0 +1,366 @@
+#include "SpectrumServer.h"
+#include "Generator.h"
+#include "Constants.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include "spdlog/fmt/fmt.h"
+
+namespace pt = boost::property_tree;
+
+#ifndef MSG_NOSIGNAL
+// without MSG_NOSIGNAL, e.g. on macOS, SIGPIPE is ignored in Run instead
+#define MSG_NOSIGNAL 0
+#define BSG_IGNORE_SIGPIPE
+#endif
+
+/**
+ * Format a number as JSON, which has no representation for NaN and infinity
+ */
+static std::string JsonNumber(double value) {
+  return std::isfinite(value) ? fmt::format("{:.17g}", value) : "null";
+}
+
+static std::string JsonString(const std::string& value) {
+  std::string result = "\"";
+  for (char c : value) {
+    if (c == '"' || c == '\\') {
+      result += '\\';
+      result += c;
+    } else if ((unsigned char)c < 0x20) {
+      result += fmt::format("\\u{:04x}", (int)c);
+    } else {
+      result += c;
+    }
+  }
+  return result + "\"";
+}
+
+/**
+ * Check whether text is a number in the JSON grammar,
+ * -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)?
+ */
+static bool IsJsonNumber(const std::string& text) {
+  auto isDigit = [](char c) { return c >= '0' && c <= '9'; };
+  std::size_t i = 0, n = text.size();
+  if (i < n && text[i] == '-') i++;
+  if (i < n && text[i] == '0') {
+    i++;
+  } else if (i < n && isDigit(text[i])) {
+    while (i < n && isDigit(text[i])) i++;
+  } else {
+    return false;
+  }
+  if (i < n && text[i] == '.') {
+    if (++i == n || !isDigit(text[i])) return false;
+    while (i < n && isDigit(text[i])) i++;
+  }
+  if (i < n && (text[i] == 'e' || text[i] == 'E')) {
+    i++;
+    if (i < n && (text[i] == '+' || text[i] == '-')) i++;
+    if (i == n || !isDigit(text[i])) return false;
+    while (i < n && isDigit(text[i])) i++;
+  }
+  return i == n;
+}
+
+/**
+ * Format the id of a request, keeping numbers as numbers and quoting anything
+ * else
+ */
+static std::string JsonId(const std::string& id) {
+  if (id.empty()) return "null";
+  return IsJsonNumber(id) ? id : JsonString(id);
+}
+
+static std::string JsonArray(bsg::Span<const double> values) {
+  std::string result = "[";
+  for (std::size_t i = 0; i < values.size(); i++) {
+    if (i > 0) result += ",";
+    result += JsonNumber(values[i]);
+  }
+  return result + "]";
+}
+
+static std::string ErrorResponse(const std::string& id, const std::string& message) {
+  return fmt::format("{{\"id\":{},\"status\":\"error\",\"message\":{}}}\n", JsonId(id), JsonString(message));
+}
+
+/**
+ * Get the values of a JSON option, using one value per element for arrays
+ */
+static std::vector<std::string> GetOptionValues(const pt::ptree& node) {
+  std::vector<std::string> values;
+  if (node.empty()) {
+    values.push_back(node.get_value<std::string>());
+  } else {
+    for (const auto& element : node) values.push_back(element.second.get_value<std::string>());
+  }
+  return values;
+}
+
+bsg::SpectrumServer::SpectrumServer(std::string socketPath, const GeneratorConfig& baseConfig, int nWorkers)
+    : socketPath(socketPath), baseConfig(baseConfig), nWorkers(std::max(1, nWorkers)) {}
+
+bsg::SpectrumServer::~SpectrumServer() {}
+
+std::unique_ptr<bsg::Generator> bsg::SpectrumServer::AcquireGenerator(const GeneratorConfig& config,
+                                                                     const std::string& key) {
+  {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    for (auto it = idleGenerators.begin(); it != idleGenerators.end(); ++it) {
+      if (it->first == key) {
+        std::unique_ptr<Generator> gen = std::move(it->second);
+        idleGenerators.erase(it);
+        return gen;
+      }
+    }
+  }
+  std::lock_guard<std::mutex> lock(initMutex);
+  return std::unique_ptr<Generator>(new Generator(config));
+}
+
+void bsg::SpectrumServer::ReleaseGenerator(const std::string& key, std::unique_ptr<Generator> gen) {
+  std::unique_ptr<Generator> evicted;
+  {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    idleGenerators.emplace_front(key, std::move(gen));
+    if (idleGenerators.size() > maxIdleGenerators) {
+      evicted = std::move(idleGenerators.back().second);
+      idleGenerators.pop_back();
+    }
+  }
+}
+
+std::string bsg::SpectrumServer::HandleRequest(const std::string& request, bool& shutdown) {
+  auto start = std::chrono::steady_clock::now();
+  unsigned long number = nRequests++;
+  shutdown = false;
+
+  pt::ptree tree;
+  try {
+    std::istringstream stream(request);
+    pt::read_json(stream, tree);
+  } catch (pt::json_parser_error& e) {
+    return ErrorResponse("", std::string("Invalid request: ") + e.what());
+  }
+  std::string id = tree.get<std::string>("id", "");
+
+  if (tree.get<std::string>("command", "") == "shutdown") {
+    shutdown = true;
+    return fmt::format("{{\"id\":{},\"status\":\"ok\"}}\n", JsonId(id));
+  }
+
+  GeneratorConfig config = baseConfig;
+  bool files = tree.get<bool>("files", false);
+  if (files) {
+    config.Set("output", fmt::format("{}_{}", baseConfig.Get<std::string>("output"), number));
+  } else {
+    config.Set("output", std::string("none"));
+  }
+  std::string input = tree.get<std::string>("input", "");
+  if (!input.empty() && !config.ReadInput(input)) {
+    return ErrorResponse(id, "Input file " + input + " cannot be found");
+  }
+  for (const char* section : {"transition", "options"}) {
+    auto child = tree.get_child_optional(section);
+    if (!child) continue;
+    for (const auto& option : *child) {
+      if (!config.Override(option.first, GetOptionValues(option.second))) {
+        return ErrorResponse(id, "Unknown option or invalid value for " + option.first);
+      }
+    }
+  }
+  std::string format = tree.get<std::string>("format", "json");
+  if (format != "json" && format != "binary") {
+    return ErrorResponse(id, "Unknown format " + format + ", use json or binary");
+  }
+  bool withSpectrum = tree.get<bool>("spectrum", true);
+
+  std::string response;
+  try {
+    // requests writing files have an output name of their own, so their
+    // Generators are never reused
+    std::string key = files ? std::string() : config.ToString();
+    std::unique_ptr<Generator> gen = AcquireGenerator(config, key);
+    bool integralOnly = config.Get<bool>("Spectrum.IntegralOnly");
+    if (integralOnly) {
+      gen->CalculateIntegrals();
+    } else {
+      gen->CalculateSpectrum();
+    }
+    // with the C correction turned on the form factors were calculated during
+    // construction, otherwise they do not enter the spectrum and are not given
+    double bAc = NAN, dAc = NAN;
+    if (gen->GetCorrectionPlan().IsEnabled(C_CORRECTION)) {
+      bAc = gen->GetWeakMagnetism();
+      dAc = gen->GetInducedTensor();
+    }
+    double halflife = config.Exists("Transition.PartialHalflife") ? config.Get<double>("Transition.PartialHalflife") : 1.;
+    double logFt = gen->CalculateLogFtValue(halflife);
+    double meanEnergy = (gen->CalculateMeanEnergy() - 1.) * ELECTRON_MASS_KEV;
+    double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    response = fmt::format("{{\"id\":{},\"status\":\"ok\",\"logft\":{},\"meanEnergy\":{},\"bAc\":{},\"dAc\":{},\"time\":{:.3f}",
+                           JsonId(id), JsonNumber(logFt), JsonNumber(meanEnergy), JsonNumber(bAc),
+                           JsonNumber(dAc), elapsed);
+    const Spectrum& spectrum = gen->GetSpectrum();
+    if (!withSpectrum || integralOnly) {
+      response += "}\n";
+    } else if (format == "json") {
+      response += ",\"W\":" + JsonArray(spectrum.GetW()) + ",\"electron\":" + JsonArray(spectrum.GetElectron()) +
+                  ",\"neutrino\":" + JsonArray(spectrum.GetNeutrino()) + "}\n";
+    } else {
+      std::size_t n = spectrum.GetSize();
+      response += fmt::format(",\"points\":{},\"bytes\":{}}}\n", n, 24 * n);
+      std::size_t offset = response.size();
+      response.resize(offset + 24 * n);
+      Span<const double> columns[3] = {spectrum.GetW(), spectrum.GetElectron(), spectrum.GetNeutrino()};
+      for (std::size_t i = 0; i < n; i++) {
+        for (int c = 0; c < 3; c++) {
+          std::uint64_t bits;
+          std::memcpy(&bits, &columns[c][i], sizeof(bits));
+          for (int b = 0; b < 8; b++) response[offset + 24 * i + 8 * c + b] = (char)((bits >> (8 * b)) & 0xff);
+        }
+      }
+    }
+    if (!files) ReleaseGenerator(key, std::move(gen));
+  } catch (std::exception& e) {
+    return ErrorResponse(id, e.what());
+  }
+  return response;
+}
+
+void bsg::SpectrumServer::Serve(int connection) {
+  std::string buffer;
+  char chunk[65536];
+  bool shutdown = false;
+  while (!shutdown) {
+    ssize_t n = read(connection, chunk, sizeof(chunk));
+    if (n <= 0) break;
+    buffer.append(chunk, n);
+    std::size_t end;
+    while (!shutdown && (end = buffer.find('\n')) != std::string::npos) {
+      std::string line = buffer.substr(0, end);
+      buffer.erase(0, end + 1);
+      if (line.find_first_not_of(" \t\r") == std::string::npos) continue;
+      std::string response = HandleRequest(line, shutdown);
+      for (std::size_t written = 0; written < response.size();) {
+        // a client which disconnected must not raise SIGPIPE and stop the server
+        ssize_t w = send(connection, response.data() + written, response.size() - written, MSG_NOSIGNAL);
+        if (w <= 0) break;
+        written += w;
+      }
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(connectionMutex);
+    openConnections.erase(connection);
+    close(connection);
+  }
+  if (shutdown && !stopping.exchange(true)) {
+    // Wake up the accept loop
+    ::shutdown(listener, SHUT_RDWR);
+  }
+}
+
+void bsg::SpectrumServer::Work() {
+  while (true) {
+    int connection;
+    {
+      std::unique_lock<std::mutex> lock(queueMutex);
+      queueCondition.wait(lock, [this] { return stopping || !pendingConnections.empty(); });
+      if (pendingConnections.empty()) return;
+      connection = pendingConnections.front();
+      pendingConnections.pop_front();
+    }
+    Serve(connection);
+  }
+}
+
+int bsg::SpectrumServer::Run() {
+  sockaddr_un address;
+  std::memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  if (socketPath.size() >= sizeof(address.sun_path)) {
+    std::cerr << "BSG ERROR: Socket path " << socketPath << " is too long." << std::endl;
+    return 1;
+  }
+  std::strcpy(address.sun_path, socketPath.c_str());
+
+#ifdef BSG_IGNORE_SIGPIPE
+  signal(SIGPIPE, SIG_IGN);
+#endif
+
+  // only replace the socket of an earlier server, never any other file
+  struct stat status;
+  if (lstat(socketPath.c_str(), &status) == 0) {
+    if (!S_ISSOCK(status.st_mode)) {
+      std::cerr << "BSG ERROR: " << socketPath << " exists and is not a socket." << std::endl;
+      return 1;
+    }
+    unlink(socketPath.c_str());
+  }
+
+  listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener < 0 || bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(listener, 64) != 0) {
+    std::cerr << "BSG ERROR: Cannot listen on " << socketPath << ": " << std::strerror(errno) << std::endl;
+    if (listener >= 0) close(listener);
+    return 1;
+  }
+  std::cout << "Listening on " << socketPath << " with " << nWorkers << " worker(s)" << std::endl;
+
+  std::vector<std::thread> workers;
+  for (int i = 0; i < nWorkers; i++) workers.emplace_back(&SpectrumServer::Work, this);
+  while (!stopping) {
+    int connection = accept(listener, NULL, NULL);
+    if (connection < 0) {
+      if (errno == EINTR) continue;
+      break;
+    }
+    {
+      std::lock_guard<std::mutex> lock(connectionMutex);
+      openConnections.insert(connection);
+    }
+    {
+      std::lock_guard<std::mutex> lock(queueMutex);
+      pendingConnections.push_back(connection);
+    }
+    queueCondition.notify_one();
+  }
+  {
+    std::lock_guard<std::mutex> lock(queueMutex);
+    stopping = true;
+  }
+  queueCondition.notify_all();
+  close(listener);
+  {
+    // Let connections which are waiting for a request finish
+    std::lock_guard<std::mutex> lock(connectionMutex);
+    for (int connection : openConnections) ::shutdown(connection, SHUT_RD);
+  }
+  unlink(socketPath.c_str());
+  for (std::thread& t : workers) t.join();
+  std::cout << "Served " << nRequests << " requests" << std::endl;
+  return 0;
+}
@@ -0,0 +1,119 @@
+#ifndef SPECTRUMSERVER
+#define SPECTRUMSERVER
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+
+#include "GeneratorConfig.h"
+
+namespace bsg {
+
+class Generator;
+
+/**
+ * Server calculating spectra on request over a local (Unix domain) socket, so
+ * that option parsing, library loading and the caches of earlier transitions
+ * are shared by all requests.
+ *
+ * Every request is a single line containing a JSON object
+ *
+ *   {"id": 1, "input": "63Ni.ini", "transition": {"Daughter.Z": 29},
+ *    "options": {"Spectrum.WeakMagnetism": 5}, "format": "json",
+ *    "spectrum": true, "files": false}
+ *
+ * where the transition is read from the input file, if given, after which the
+ * entries of transition and options override single options. Array values are
+ * passed as multiple values of the option. Requests are calculated in memory,
+ * unless files is true, in which case the usual output files of request n are
+ * written to <output>_n. A request {"command": "shutdown"} stops the server.
+ *
+ * Every response starts with a line containing a JSON object with the id, the
+ * status ("ok" or "error" with a message), the log f(t) value, mean energy,
+ * b/Ac, d/Ac, which are null when the C correction is turned off, and the
+ * time taken in ms. With the json format the spectrum is
+ * included as the arrays W, electron and neutrino. With the binary format the
+ * line ends with the number of points and bytes, and is followed by that
+ * number of bytes containing W, the electron and the neutrino decay rate of
+ * every point as little-endian doubles.
+ *
+ * Connections are served concurrently by a fixed number of worker threads,
+ * further connections wait until a worker is free, and requests of a single
+ * connection are answered in order. Generators of requests without output
+ * files are kept after the request, so that a later request with the same
+ * options reuses the fitted charge distribution, nuclear structure and
+ * prepared corrections instead of constructing a new Generator.
+ */
+class SpectrumServer {
+ public:
+  /**
+   * Constructor
+   *
+   * @param socketPath path of the socket to listen on
+   * @param baseConfig options shared by all requests
+   * @param nWorkers number of connections served concurrently
+   */
+  SpectrumServer(std::string socketPath, const GeneratorConfig& baseConfig, int nWorkers = 1);
+  ~SpectrumServer();
+
+  /**
+   * Listen for connections until a shutdown request arrives
+   *
+   * @returns 0 on a clean shutdown, 1 if the socket cannot be created or a
+   * file other than a socket exists at its path
+   */
+  int Run();
+
+  /**
+   * Answer a single request
+   *
+   * @param request the request line
+   * @param shutdown set to true for a shutdown request
+   * @returns the response, including any binary payload
+   */
+  std::string HandleRequest(const std::string& request, bool& shutdown);
+
+ private:
+  void Serve(int connection);
+  /**
+   * Serve queued connections until the server stops
+   */
+  void Work();
+  /**
+   * Take an idle Generator for a configuration, or construct one
+   *
+   * @param key the text of the configuration, see GeneratorConfig::ToString
+   */
+  std::unique_ptr<Generator> AcquireGenerator(const GeneratorConfig& config, const std::string& key);
+  /**
+   * Keep a Generator for later requests with the same configuration
+   */
+  void ReleaseGenerator(const std::string& key, std::unique_ptr<Generator> gen);
+
+  std::string socketPath; /**< path of the listening socket */
+  GeneratorConfig baseConfig; /**< options shared by all requests */
+  int nWorkers; /**< number of connections served concurrently */
+  std::mutex initMutex; /**< serializes the construction of Generators */
+  std::mutex cacheMutex; /**< guards idleGenerators */
+  std::list<std::pair<std::string, std::unique_ptr<Generator> > > idleGenerators; /**< Generators not in use, most recently used first */
+  static const std::size_t maxIdleGenerators = 16; /**< number of idle Generators kept */
+  std::mutex queueMutex; /**< guards pendingConnections */
+  std::condition_variable queueCondition; /**< signals new connections and the shutdown to the workers */
+  std::deque<int> pendingConnections; /**< accepted connections waiting for a worker */
+  std::atomic<unsigned long> nRequests{0}; /**< number of requests received */
+  std::atomic<bool> stopping{false}; /**< set when a shutdown request arrived */
+  std::mutex connectionMutex; /**< guards openConnections */
+  std::set<int> openConnections; /**< descriptors of the connections being served */
+  int listener = -1; /**< descriptor of the listening socket */
+};
+
+}
+
+#endif
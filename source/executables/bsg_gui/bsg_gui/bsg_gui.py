@@ -11,7 +11,7 @@ from shell import Shell, CommandError
 import qdarkstyle
 import os
 
-from PySide import QtGui
+from PySide import QtCore, QtGui
 
 from ui.MainWindowGUI import Ui_MainWindow
 
@@ -21,10 +21,41 @@ import numpy as np
 
 import utils.utilities as ut
 
+try:
+    import bsg
+except ImportError:
+    bsg = None
+
+ELECTRON_MASS_KEV = 510.998902
+
 def setCheckBoxState(cb, b):
     if (cb.isChecked() and not b) or (not cb.isChecked() and b):
         cb.toggle()
 
+class BSGModuleWorker(QtCore.QThread):
+    """
+    Constructs a Generator and calculates its spectrum with the bsg module
+    outside of the UI thread. The module releases the GIL while calculating,
+    so that the UI keeps handling events.
+    """
+    calculated = QtCore.Signal(object, object, object)
+    failed = QtCore.Signal(str)
+
+    def __init__(self, iniName, config, options, parent=None):
+        QtCore.QThread.__init__(self, parent)
+        self.iniName = iniName
+        self.config = config
+        self.options = options
+
+    def run(self):
+        try:
+            gen = bsg.Generator(input=self.iniName, config=self.config, options=self.options)
+            W, electron, neutrino = gen.calculate_spectrum()
+        except (IOError, ValueError, RuntimeError) as e:
+            self.failed.emit(str(e))
+            return
+        self.calculated.emit(W, electron, neutrino)
+
 class BSG_UI(QtGui.QMainWindow):
 
     def __init__(self):
@@ -38,6 +69,7 @@ class BSG_UI(QtGui.QMainWindow):
         self.execPath = ''
         self.exchangePath = ''
         self.robtdFile = ''
+        self.bsgWorker = None
 
         self.unsavedTransitionChanges = list()
 
@@ -440,7 +472,7 @@ class BSG_UI(QtGui.QMainWindow):
         self.checkUnsavedTransitionChanges()
 
         outputName = self.ui.le_outputName.text()
-        if self.execPath == '':
+        if bsg is None and self.execPath == '':
             QtGui.QErrorMessage(self).showMessage("Set the path for the generator executable.")
         if self.iniName == '':
             QtGui.QErrorMessage(self).showMessage("No ini file found.")
@@ -454,6 +486,65 @@ class BSG_UI(QtGui.QMainWindow):
 
         self.log("Performing BSG Calculation...")
         self.status("Calculating...")
+        if bsg is not None:
+            self.runBSGModule(outputName)
+        else:
+            self.runBSGExec(outputName)
+            self.status("Ready!")
+
+    def getSpectrumOptions(self):
+        options = {}
+        for key in self.spectrumCheckBoxes:
+            options["Spectrum.{0}".format(self.spectrumCheckBoxes[key])] = key.isChecked()
+        for key in self.spectrumComboBoxes:
+            options["Spectrum.{0}".format(self.spectrumComboBoxes[key])] = key.currentText()
+        for key in self.spectrumDSB:
+            if key.isEnabled():
+                options["Spectrum.{0}".format(self.spectrumDSB[key])] = key.value()
+        if self.ui.cb_enforceNME.isChecked():
+            for key in self.spectrumNME:
+                options["Spectrum.{0}".format(self.spectrumNME[key])] = key.value()
+        for key in self.computationalComboBoxes:
+            options["Computational.{0}".format(self.computationalComboBoxes[key])] = key.currentText()
+        for key in self.computationalCheckBoxes:
+            options["Computational.{0}".format(self.computationalCheckBoxes[key])] = key.isChecked()
+        for key in self.computationalDSB:
+            options["Computational.{0}".format(self.computationalDSB[key])] = key.value()
+        return options
+
+    def plotSpectrum(self, E, electron):
+        self.ui.gv_plotSpectrum.plot(x=E, y=electron, pen=self.plotColors[self.currentPlotIndex%len(self.plotColors)])
+        self.currentPlotIndex += 1
+
+    def runBSGModule(self, outputName):
+        options = {"output": outputName}
+        if self.ui.cb_exchange.isChecked():
+            options["exchangedata"] = self.exchangePath
+        config = None
+        if self.ui.rb_configFile.isChecked():
+            config = self.configName
+        else:
+            options.update(self.getSpectrumOptions())
+        self.ui.b_runBSG.setEnabled(False)
+        self.bsgWorker = BSGModuleWorker(self.iniName, config, options, self)
+        self.bsgWorker.calculated.connect(self.moduleCalculated)
+        self.bsgWorker.failed.connect(self.moduleFailed)
+        self.bsgWorker.finished.connect(self.moduleFinished)
+        self.bsgWorker.start()
+
+    def moduleCalculated(self, W, electron, neutrino):
+        self.plotSpectrum((W-1.)*ELECTRON_MASS_KEV, electron)
+        self.log("Spectrum calculation OK")
+
+    def moduleFailed(self, message):
+        QtGui.QErrorMessage(self).showMessage(message)
+
+    def moduleFinished(self):
+        self.bsgWorker = None
+        self.ui.b_runBSG.setEnabled(True)
+        self.status("Ready!")
+
+    def runBSGExec(self, outputName):
         command = "{0} -i {1} -o {2}".format(self.execPath, self.iniName, outputName)
         if self.ui.cb_exchange.isChecked():
             command += " -e {}".format(self.exchangePath)
@@ -461,22 +552,8 @@ class BSG_UI(QtGui.QMainWindow):
         if self.ui.rb_configFile.isChecked():
             command += " -c {}".format(self.configName)
         else:
-            for key in self.spectrumCheckBoxes:
-                command += " --Spectrum.{0}={1}".format(self.spectrumCheckBoxes[key], key.isChecked())
-            for key in self.spectrumComboBoxes:
-                command += " --Spectrum.{0}={1}".format(self.spectrumComboBoxes[key], key.currentText())
-            for key in self.spectrumDSB:
-                if key.isEnabled():
-                    command += " --Spectrum.{0}={1}".format(self.spectrumDSB[key], key.value())
-            if self.ui.cb_enforceNME.isChecked():
-                for key in self.spectrumNME:
-                    command += " --Spectrum.{0}={1}".format(self.spectrumNME[key], key.value())
-            for key in self.computationalComboBoxes:
-                command += ' --Computational.{0}={1}'.format(self.computationalComboBoxes[key], key.currentText())
-            for key in self.computationalCheckBoxes:
-                command += ' -- Computational.{0}={1}'.format(self.computationalCheckBoxes[key], key.isChecked())
-            for key in self.computationalDSB:
-                command += ' --Computational.{0}={1}'.format(self.computationalDSB[key], key.value())
+            for name, value in self.getSpectrumOptions().items():
+                command += " --{0}={1}".format(name, value)
 
         print("Executing command: %s" % command)
         try:
@@ -485,12 +562,10 @@ class BSG_UI(QtGui.QMainWindow):
             if sh.output(raw=True) != '':
                 QtGui.QErrorMessage(self).showMessage(sh.output(raw=True))
             spectrum = np.genfromtxt(outputName + '.raw')
-            self.ui.gv_plotSpectrum.plot(x=spectrum[:, 1], y=spectrum[:,2], pen=self.plotColors[self.currentPlotIndex%len(self.plotColors)])
-            self.currentPlotIndex += 1
+            self.plotSpectrum(spectrum[:, 1], spectrum[:,2])
             self.log("Spectrum calculation OK")
         except CommandError as e:
             QtGui.QErrorMessage(self).showMessage(('CommandError({0}): {1}'.format(e.errno, e.strerror)))
-        self.status("Ready!")
 
     def changeBSGExec(self):
         filename = QtGui.QFileDialog.getOpenFileName(self, "Choose BSG exec")[0]
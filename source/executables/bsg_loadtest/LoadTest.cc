@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <boost/program_options.hpp>
+
+namespace po = boost::program_options;
+
+/**
+ * Load test of the spectrum server of bsg_exec --serve.
+ * A number of connections send requests, taken in turn from a file with one
+ * JSON request per line, as fast as the server answers them. The latency of
+ * every request is measured from sending the request until the complete
+ * response, including any binary spectrum, was received.
+ *
+ * Usage: bsg_loadtest --socket bsg.sock --requests requests.jsonl -n 1000 -c 8
+ */
+
+/**
+ * Connection to the server which reads responses line by line
+ */
+class Connection {
+ public:
+  Connection(std::string socketPath) {
+    sockaddr_un address;
+    std::memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd >= 0 && connect(fd, (sockaddr*)&address, sizeof(address)) != 0) {
+      close(fd);
+      fd = -1;
+    }
+  }
+  ~Connection() {
+    if (fd >= 0) close(fd);
+  }
+
+  inline bool IsOpen() const { return fd >= 0; };
+
+  bool Send(const std::string& line) {
+    std::string data = line + "\n";
+    for (std::size_t written = 0; written < data.size();) {
+      ssize_t n = write(fd, data.data() + written, data.size() - written);
+      if (n <= 0) return false;
+      written += n;
+    }
+    return true;
+  }
+
+  /**
+   * Receive one response, skipping the binary spectrum which follows the
+   * first line when it announces a number of bytes
+   */
+  bool Receive(std::string& line) {
+    if (!Fill('\n')) return false;
+    std::size_t end = buffer.find('\n');
+    line = buffer.substr(0, end);
+    buffer.erase(0, end + 1);
+
+    std::size_t bytes = 0;
+    std::size_t position = line.find("\"bytes\":");
+    if (position != std::string::npos) bytes = std::strtoull(line.c_str() + position + 8, NULL, 10);
+    while (buffer.size() < bytes) {
+      if (!Read()) return false;
+    }
+    buffer.erase(0, bytes);
+    return true;
+  }
+
+ private:
+  bool Read() {
+    char chunk[65536];
+    ssize_t n = read(fd, chunk, sizeof(chunk));
+    if (n <= 0) return false;
+    buffer.append(chunk, n);
+    return true;
+  }
+  bool Fill(char delimiter) {
+    while (buffer.find(delimiter) == std::string::npos) {
+      if (!Read()) return false;
+    }
+    return true;
+  }
+
+  int fd;
+  std::string buffer;
+};
+
+double Percentile(const std::vector<double>& sorted, double p) {
+  if (sorted.empty()) return 0.;
+  std::size_t i = std::min(sorted.size() - 1, (std::size_t)(p / 100. * sorted.size()));
+  return sorted[i];
+}
+
+int main(int argc, char** argv) {
+  std::string socketPath, requestFile;
+  int nRequests, nConnections;
+
+  po::options_description options("bsg_loadtest options");
+  options.add_options()("help,h", "Produce help message")(
+      "socket,s", po::value<std::string>(&socketPath)->required(),
+      "Specify the socket of the server.")(
+      "requests,r", po::value<std::string>(&requestFile)->required(),
+      "Specify a file with one JSON request per line, which are sent in turn.")(
+      "number,n", po::value<int>(&nRequests)->default_value(100),
+      "Specify the total number of requests.")(
+      "connections,c", po::value<int>(&nConnections)->default_value(4),
+      "Specify the number of concurrent connections.");
+
+  po::variables_map vm;
+  try {
+    po::store(po::parse_command_line(argc, argv, options), vm);
+    if (vm.count("help")) {
+      std::cout << options << std::endl;
+      return 0;
+    }
+    po::notify(vm);
+  } catch (po::error& e) {
+    std::cerr << "ERROR: " << e.what() << "\n" << options << std::endl;
+    return 1;
+  }
+
+  std::vector<std::string> requests;
+  std::ifstream requestStream(requestFile.c_str());
+  std::string line;
+  while (getline(requestStream, line)) {
+    if (line.find_first_not_of(" \t\r") != std::string::npos) requests.push_back(line);
+  }
+  if (requests.empty()) {
+    std::cerr << "ERROR: No requests found in " << requestFile << std::endl;
+    return 1;
+  }
+  nConnections = std::max(1, std::min(nConnections, nRequests));
+
+  std::vector<std::vector<double> > latencies(nConnections);
+  std::atomic<int> next(0), errors(0), failedConnections(0);
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int c = 0; c < nConnections; c++) {
+    threads.emplace_back([&, c]() {
+      Connection connection(socketPath);
+      if (!connection.IsOpen()) {
+        failedConnections++;
+        return;
+      }
+      int i;
+      std::string response;
+      while ((i = next++) < nRequests) {
+        auto sent = std::chrono::steady_clock::now();
+        if (!connection.Send(requests[i % requests.size()]) || !connection.Receive(response)) {
+          errors++;
+          return;
+        }
+        latencies[c].push_back(
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - sent).count());
+        if (response.find("\"status\":\"ok\"") == std::string::npos) errors++;
+      }
+    });
+  }
+  for (std::thread& t : threads) t.join();
+  double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::vector<double> all;
+  for (const std::vector<double>& l : latencies) all.insert(all.end(), l.begin(), l.end());
+  std::sort(all.begin(), all.end());
+  double mean = 0.;
+  for (double l : all) mean += l / all.size();
+
+  if (failedConnections > 0) {
+    std::cerr << "ERROR: " << failedConnections << " connection(s) to " << socketPath << " failed" << std::endl;
+  }
+  std::printf("Requests:    %zu completed, %d failed, %d connection(s)\n", all.size(), (int)errors, nConnections);
+  std::printf("Throughput:  %.2f requests/s\n", all.size() / std::max(elapsed, 1e-9));
+  std::printf("Latency:     mean %.3f ms, p50 %.3f ms, p99 %.3f ms, max %.3f ms\n", mean,
+              Percentile(all, 50.), Percentile(all, 99.), all.empty() ? 0. : all.back());
+  return errors > 0 || failedConnections > 0 ? 1 : 0;
+}
@@ -0,0 +1,300 @@
+#include "BSGOptionContainer.h"
+#include "ChargeDistributions.h"
+#include "CorrectionPlan.h"
+#include "Generator.h"
+#include "GeneratorConfig.h"
+#include "Spectrum.h"
+#include "SpectrumInterpolant.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <boost/program_options.hpp>
+
+#include "spdlog/spdlog.h"
+
+namespace po = boost::program_options;
+namespace fs = std::filesystem;
+
+/**
+ * Validation of the fast paths of the spectrum calculation against a
+ * reference evaluation. For every input file the spectrum is calculated as
+ * in CalculateSpectrum, i.e. with the batch kernels, interpolation tables and
+ * energies shared between the electron and neutrino, and point by point as in
+ * CalculateDecayRate with every correction evaluated from its original
+ * full-argument spectral function (Generator::BuildReferenceCorrectionPlan).
+ * The maximal and RMS relative deviation of the electron and neutrino part of
+ * every correction and of the decay rates, the deviation in log ft and the
+ * speedup are reported, as well as the deviation of the interpolated
+ * spectrum (Spectrum.Interpolate) and the number of energies shared between
+ * the electron and neutrino on a symmetric grid. In
+ * ROOT builds the GSL fit of the charge distribution, which replaces the ROOT
+ * fit when configuring without ROOT, is compared with the ROOT fit. The
+ * program fails when a deviation exceeds its tolerance or not all energies of
+ * the symmetric grid are shared. Values which are NaN in both paths, and a
+ * spectrum which vanishes in both, are not deviations but are reported.
+ *
+ * Usage: bsg_validate --data data [--tolerance 1e-6] [--logft-tolerance 1e-6]
+ */
+
+/**
+ * Accumulates relative deviations of fast values from reference values
+ */
+struct Deviation {
+  double max = 0.;
+  double sumSquares = 0.;
+  std::size_t n = 0;
+  std::size_t nNaN = 0;
+
+  void Add(double fast, double reference) {
+    // a NaN in both paths is the behaviour of the original spectral function,
+    // which is reported separately rather than as a deviation
+    if (fast == reference || (std::isnan(fast) && std::isnan(reference))) {
+      if (std::isnan(fast)) nNaN++;
+      n++;
+      return;
+    }
+    double d = reference != 0. ? std::abs(fast / reference - 1.) : std::abs(fast);
+    if (!std::isfinite(d)) d = INFINITY;
+    max = std::max(max, d);
+    sumSquares += d * d;
+    n++;
+  }
+  inline double GetRMS() const { return n > 0 ? std::sqrt(sumSquares / n) : 0.; };
+};
+
+/**
+ * Evaluate the electron or neutrino part of a single correction on a grid,
+ * using its batch version when available as the fast path does
+ */
+static std::vector<double> EvaluateCorrection(const bsg::Correction& c, const std::vector<double>& W,
+                                              bool neutrino) {
+  const bsg::BatchFunction& batch = neutrino ? c.neutrinoBatch : c.electronBatch;
+  const std::function<double(double)>& f = neutrino ? c.neutrino : c.electron;
+  std::vector<double> result(W.size());
+  if (batch) {
+    batch(W.data(), result.data(), W.size());
+  } else {
+    for (std::size_t i = 0; i < W.size(); i++) result[i] = f(W[i]);
+  }
+  return result;
+}
+
+static void PrintDeviation(const std::string& name, const Deviation& d, double tolerance) {
+  std::printf("  %-26s %14.3g %14.3g%s\n", name.c_str(), d.max, d.GetRMS(),
+              d.max > tolerance ? "  FAILED" : "");
+  if (d.nNaN > 0) std::printf("  %-26s NaN in both paths at %zu of %zu energies\n", "", d.nNaN, d.n);
+}
+
+/**
+ * Validate a single transition
+ *
+ * @returns whether all deviations are within the tolerances
+ */
+static bool Validate(const bsg::GeneratorConfig& config, const std::string& name, double tolerance,
+                     double logFtTolerance) {
+  bsg::Generator gen(config);
+  std::vector<double> W = gen.BuildGrid();
+  const bsg::CorrectionPlan& fast = gen.GetCorrectionPlan();
+  bsg::CorrectionPlan reference = gen.BuildReferenceCorrectionPlan();
+
+  auto start = std::chrono::steady_clock::now();
+  std::vector<double> electron, neutrino;
+  fast.Evaluate(W, electron, neutrino, 1);
+  double fastTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  start = std::chrono::steady_clock::now();
+  std::vector<double> referenceElectron(W.size()), referenceNeutrino(W.size());
+  for (std::size_t i = 0; i < W.size(); i++) {
+    std::tie(referenceElectron[i], referenceNeutrino[i]) = reference.Evaluate(W[i]);
+  }
+  double referenceTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+  std::printf("%s: %zu points, %.3g ms fast, %.3g ms reference, speedup %.3g\n", name.c_str(), W.size(),
+              1e3 * fastTime, 1e3 * referenceTime, referenceTime / std::max(fastTime, 1e-12));
+  std::printf("  %-26s %14s %14s\n", "Correction", "max rel dev", "rms rel dev");
+
+  bool passed = true;
+  const std::vector<bsg::Correction>& fastCorrections = fast.GetCorrections();
+  const std::vector<bsg::Correction>& referenceCorrections = reference.GetCorrections();
+  std::vector<double> Wv(W.size());
+  for (std::size_t i = 0; i < W.size(); i++) Wv[i] = fast.GetEndpoint() - W[i] + 1.;
+  for (std::size_t c = 0; c < fastCorrections.size() && c < referenceCorrections.size(); c++) {
+    std::string correctionName = bsg::CorrectionPlan::GetName(fastCorrections[c].type);
+    std::vector<double> fastValues = EvaluateCorrection(fastCorrections[c], W, false);
+    std::vector<double> fastNeutrinoValues = EvaluateCorrection(fastCorrections[c], Wv, true);
+    Deviation d, neutrinoD;
+    for (std::size_t i = 0; i < W.size(); i++) {
+      d.Add(fastValues[i], referenceCorrections[c].electron(W[i]));
+      neutrinoD.Add(fastNeutrinoValues[i], referenceCorrections[c].neutrino(Wv[i]));
+    }
+    PrintDeviation(correctionName, d, tolerance);
+    PrintDeviation(correctionName + " (neutrino)", neutrinoD, tolerance);
+    passed = passed && d.max <= tolerance && neutrinoD.max <= tolerance;
+  }
+
+  Deviation electronDeviation, neutrinoDeviation;
+  for (std::size_t i = 0; i < W.size(); i++) {
+    electronDeviation.Add(electron[i], referenceElectron[i]);
+    neutrinoDeviation.Add(neutrino[i], referenceNeutrino[i]);
+  }
+  PrintDeviation("Electron rate", electronDeviation, tolerance);
+  PrintDeviation("Neutrino rate", neutrinoDeviation, tolerance);
+  passed = passed && electronDeviation.max <= tolerance && neutrinoDeviation.max <= tolerance;
+
+  // on a grid symmetric about (W0 + 1)/2 every neutrino energy is an
+  // electron energy, so all of them should be shared
+  if (W.size() > 1) {
+    double W0 = fast.GetEndpoint();
+    std::vector<double> symmetricW(W.size());
+    for (std::size_t i = 0; i < W.size(); i++) symmetricW[i] = 1. + i * (W0 - 1.) / (W.size() - 1);
+    std::vector<double> symmetricElectron, symmetricNeutrino;
+    std::size_t merged = fast.Evaluate(symmetricW, symmetricElectron, symmetricNeutrino, 1);
+    std::printf("  %-26s %zu of %zu energies on a symmetric grid%s\n", "Shared", merged, W.size(),
+                merged != W.size() ? "  FAILED" : "");
+    passed = passed && merged == W.size();
+  }
+
+  if (!W.empty()) {
+    start = std::chrono::steady_clock::now();
+    bsg::SpectrumInterpolant interpolant = gen.BuildSpectrumInterpolant(W.front(), W.back(), 1);
+    std::vector<double> interpolatedElectron, interpolatedNeutrino;
+    std::size_t direct = interpolant.Evaluate(W, interpolatedElectron, interpolatedNeutrino, 1);
+    double interpolatedTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    Deviation interpolatedElectronDeviation, interpolatedNeutrinoDeviation;
+    for (std::size_t i = 0; i < W.size(); i++) {
+      interpolatedElectronDeviation.Add(interpolatedElectron[i], referenceElectron[i]);
+      interpolatedNeutrinoDeviation.Add(interpolatedNeutrino[i], referenceNeutrino[i]);
+    }
+    PrintDeviation("Interpolated electron", interpolatedElectronDeviation, tolerance);
+    PrintDeviation("Interpolated neutrino", interpolatedNeutrinoDeviation, tolerance);
+    std::printf("  %-26s %zu pieces, %zu evaluations, %zu points direct, %.3g ms\n", "Interpolation",
+                interpolant.GetNumberOfPieces(), interpolant.GetEvaluations(), direct, 1e3 * interpolatedTime);
+    passed = passed && interpolatedElectronDeviation.max <= tolerance &&
+             interpolatedNeutrinoDeviation.max <= tolerance;
+  }
+
+#ifdef BSG_USE_ROOT
+  {
+    int Z = gen.GetProtonNumber();
+    double rms = gen.GetRMSRadius();
+    start = std::chrono::steady_clock::now();
+    double rootFit = bsg::ChargeDistributions::FitHODist(Z, rms);
+    double rootTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    double gslFit = bsg::ChargeDistributions::FitHODistGSL(Z, rms);
+    double gslTime = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    Deviation fitDeviation;
+    fitDeviation.Add(gslFit, rootFit);
+    PrintDeviation("Charge fit GSL/ROOT", fitDeviation, tolerance);
+    std::printf("  %-26s A = %.10g ROOT in %.3g ms, %.10g GSL in %.3g ms\n", "Charge fit", rootFit,
+                1e3 * rootTime, gslFit, 1e3 * gslTime);
+    passed = passed && fitDeviation.max <= tolerance;
+  }
+#endif
+
+  // Only the phase space integral f differs between the two, so that the
+  // deviation in log ft is that in log f
+  double f = bsg::Spectrum(W, electron, neutrino).Integrate(0);
+  double referenceF = bsg::Spectrum(W, referenceElectron, referenceNeutrino).Integrate(0);
+  double logFtDeviation = f == referenceF ? 0. : std::abs(std::log10(f) - std::log10(referenceF));
+  if (!std::isfinite(logFtDeviation)) logFtDeviation = INFINITY;
+  std::printf("  %-26s %14.3g%s\n", "log ft", logFtDeviation,
+              logFtDeviation > logFtTolerance ? "  FAILED" : (f > 0. ? "" : "  (f vanishes in both paths)"));
+  return passed && logFtDeviation <= logFtTolerance;
+}
+
+int main(int argc, char** argv) {
+  std::string dataDir, configName, exchangeName, outputDir;
+  double tolerance, logFtTolerance;
+
+  po::options_description options("bsg_validate options");
+  options.add_options()("help,h", "Produce help message")(
+      "data,d", po::value<std::string>(&dataDir)->default_value("data"),
+      "Specify the data directory, whose init subdirectory is searched for "
+      "input files.")(
+      "config,c", po::value<std::string>(&configName),
+      "Specify the configuration file, by default config.txt in the data "
+      "directory.")(
+      "exchangedata,e", po::value<std::string>(&exchangeName),
+      "Specify the atomic exchange parameters file, by default "
+      "ExchangeData.dat in the data directory.")(
+      "output,o", po::value<std::string>(&outputDir)->default_value("validation"),
+      "Specify the directory for the output files of the transitions.")(
+      "tolerance", po::value<double>(&tolerance)->default_value(1e-6),
+      "Set the largest allowed relative deviation of any correction and "
+      "decay rate.")(
+      "logft-tolerance", po::value<double>(&logFtTolerance)->default_value(1e-6),
+      "Set the largest allowed deviation in log ft.")(
+      "as-configured",
+      "Only validate the corrections enabled in the configuration file, "
+      "instead of turning on all of them.");
+
+  po::variables_map vm;
+  try {
+    po::store(po::parse_command_line(argc, argv, options), vm);
+    if (vm.count("help")) {
+      std::cout << options << std::endl;
+      return 0;
+    }
+    po::notify(vm);
+  } catch (po::error& e) {
+    std::cerr << "ERROR: " << e.what() << "\n" << options << std::endl;
+    return 1;
+  }
+  if (configName.empty()) configName = dataDir + "/config.txt";
+  if (exchangeName.empty()) exchangeName = dataDir + "/ExchangeData.dat";
+
+  std::vector<std::string> inputs;
+  std::error_code error;
+  for (fs::recursive_directory_iterator it(dataDir + "/init", error), end; !error && it != end; it.increment(error)) {
+    if (it->path().extension() == ".ini") inputs.push_back(it->path().string());
+  }
+  std::sort(inputs.begin(), inputs.end());
+  if (inputs.empty()) {
+    std::cerr << "ERROR: No input files found in " << dataDir << "/init" << std::endl;
+    return 1;
+  }
+  fs::create_directories(outputDir, error);
+
+  // The transitions are read per input file below, so the option containers
+  // are not given one and should not complain about it
+  std::string exe = "bsg_validate", c = "-c", e = "-e";
+  char* containerArgs[] = {&exe[0], &c[0], &configName[0], &e[0], &exchangeName[0], NULL};
+  spdlog::set_level(spdlog::level::off);
+  bsg::BSGOptionContainer::GetInstance(5, containerArgs);
+  spdlog::set_level(spdlog::level::info);
+
+  std::vector<std::string> allCorrections = {"Phasespace", "Fermi", "C", "Relativistic", "ESDeformation",
+                                             "ESFiniteSize", "U", "CoulombRecoil", "Radiative", "Recoil",
+                                             "Screening", "Exchange", "AtomicMismatch"};
+  int failed = 0;
+  for (const std::string& input : inputs) {
+    std::string name = fs::relative(input, dataDir + "/init").string();
+    bsg::GeneratorConfig config = bsg::GeneratorConfig::FromOptions();
+    config.ReadInput(input);
+    config.Override("output", {outputDir + "/" + fs::path(input).stem().string()});
+    if (!vm.count("as-configured")) {
+      for (const std::string& correction : allCorrections) config.Override("Spectrum." + correction, {"true"});
+    }
+    try {
+      if (!Validate(config, name, tolerance, logFtTolerance)) failed++;
+    } catch (std::exception& ex) {
+      std::printf("%s: FAILED with %s\n", name.c_str(), ex.what());
+      failed++;
+    }
+    std::printf("\n");
+  }
+  std::printf("%zu transitions validated, %d failed (tolerance %g, log ft tolerance %g)\n", inputs.size(), failed,
+              tolerance, logFtTolerance);
+  return failed > 0 ? 1 : 0;
+}
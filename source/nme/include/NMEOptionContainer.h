@@ -60,6 +60,10 @@ class NMEOptionContainer {
      vm.clear();
      po::notify(vm);
    };
+  /**
+   * Get a copy of all options, e.g. to construct a GeneratorConfig
+   */
+  inline po::variables_map GetVariablesMap() const { return vm; };
 
   void ParseCmdLineOptions(int, char**);
   void ParseConfigOptions(std::string);
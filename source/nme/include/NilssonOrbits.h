@@ -8,6 +8,9 @@
 
 #include <iostream>
 #include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <string>
 
 #include "gsl/gsl_eigen.h"
 #include "gsl/gsl_matrix.h"
@@ -80,6 +83,16 @@ using std::endl;
 
 namespace utilities = bsg::utilities;
 
+/**
+ * Loggers of the transition for which the single particle states are
+ * calculated
+ */
+struct Loggers {
+  std::shared_ptr<spdlog::logger> console; /**< warnings */
+  std::shared_ptr<spdlog::logger> debugFile; /**< debugging output */
+  std::shared_ptr<spdlog::logger> nmeResults; /**< the selected states */
+};
+
 /**
  * Value of harmonic oscillator function at radius x
  *
@@ -147,10 +160,11 @@ inline double VNORM(int n, int l) {
  *potential
  * @param SDW array containing values for radial integrals in deformed
  *Woods-Saxon potential
+ * @param dbl the debugging logger
  */
 inline void WoodsSaxon(double V0, double R, double A0, double V0S, double A,
-                       double Z, int nMax, double SW[2][84], double SDW[462]) {
-  auto dbl = spdlog::get("debug_file");
+                       double Z, int nMax, double SW[2][84], double SDW[462],
+                       const std::shared_ptr<spdlog::logger>& dbl) {
   dbl->debug("Entered WoodsSaxon");
   double FINT[3] = {};
   double S[3][4] = {};
@@ -273,11 +287,12 @@ inline void WoodsSaxon(double V0, double R, double A0, double V0S, double A,
  * @param dim dimension of the matrix
  * @param eVecs pointer to an array in which to place the eigenvectors
  * @param eVals reference to a vector in which to put the eigenvalues
+ * @param dbl the debugging logger
  * @param onlyUpper boolean to say whether only the upper part was given
  */
 inline void Eigen(double* A, int dim, double* eVecs, std::vector<double>& eVals,
+                  const std::shared_ptr<spdlog::logger>& dbl,
                   bool onlyUpper = true) {
-  auto dbl = spdlog::get("debug_file");
   dbl->debug("Entered Eigen");
   gsl_matrix* aNew = gsl_matrix_alloc(dim, dim);
   // Loop over upper half of matrix
@@ -346,13 +361,15 @@ inline void Eigen(double* A, int dim, double* eVecs, std::vector<double>& eVals,
  * @param A mass number
  * @param Z proton number
  * @param nMax maximum number of oscillator shells
+ * @param loggers the loggers of the transition
  * @returns vector a SingleParticleState objects of all bound eigenstates in the
  *potential
  */
 inline std::vector<SingleParticleState> Calculate(
     double spin, double beta2, double beta4, double beta6, double V0, double R,
-    double A0, double V0S, double A, double Z, int nMax) {
-  auto dbl = spdlog::get("debug_file");
+    double A0, double V0S, double A, double Z, int nMax,
+    const Loggers& loggers) {
+  const std::shared_ptr<spdlog::logger>& dbl = loggers.debugFile;
   dbl->debug("Entered Calculate");
   double SW[2][84] = {};
   double SDW[462] = {};
@@ -383,7 +400,7 @@ inline std::vector<SingleParticleState> Calculate(
 
   std::vector<SingleParticleState> states;
 
-  WoodsSaxon(V0, R, A0, V0S, A, Z, nMax, SW, SDW);
+  WoodsSaxon(V0, R, A0, V0S, A, Z, nMax, SW, SDW, dbl);
 
   dbl->debug("Past WoodsSaxon");
 
@@ -431,7 +448,7 @@ inline std::vector<SingleParticleState> Calculate(
       }
     }
     std::vector<double> eVals;
-    Eigen(hamM, II - NIM, eVecs, eVals);
+    Eigen(hamM, II - NIM, eVecs, eVals, dbl);
 
     int index = 0.0;
     for (int i = NI; i <= II; i++) {
@@ -467,12 +484,12 @@ inline std::vector<SingleParticleState> Calculate(
     }
   }
   if (K == 0) {
-    spdlog::get("console")
-        ->warn("No harmonic oscillator single particle states below 10 MeV.");
+    loggers.console->warn(
+        "No harmonic oscillator single particle states below 10 MeV.");
     return states;
   }
 
-  /*spdlog::get("nme_results_file")->info("Spherical Woods-Saxon expansion in
+  /*loggers.nmeResults->info("Spherical Woods-Saxon expansion in
   Harmonic Oscillator basis.");
   for (int KKK = 1; KKK <= K; KKK += 12) {
     int KKKK = std::min(K, KKK + 11);
@@ -610,7 +627,7 @@ inline std::vector<SingleParticleState> Calculate(
           hamM[NK - 1] += eValsWS[N0 - 1];
         }
         std::vector<double> eVals;
-        Eigen(hamM, KKK, eVecs, eVals);
+        Eigen(hamM, KKK, eVecs, eVals, dbl);
         int N0 = 0;
         for (int MU = 1; MU <= KKK; MU++) {
           N0 += MU;
@@ -743,16 +760,17 @@ inline bool StateSorter(SingleParticleState const& lhs,
  * @param V0 depth of the Woods-Saxon potential
  * @param A0
  * @param VS strength of the pion-exchange
+ * @param loggers the loggers of the transition
  * @returns vector of all bound single particle states, sorted for increasing
  *energy
  */
 inline std::vector<SingleParticleState> GetAllSingleParticleStates(
     int Z, int N, int A, int dJ, double R, double beta2, double beta4,
-    double beta6, double V0, double A0, double VS) {
+    double beta6, double V0, double A0, double VS, const Loggers& loggers) {
   std::vector<SingleParticleState> evenStates =
-      Calculate(6.5, beta2, beta4, beta6, V0, R, A0, VS, A, Z, 12);
+      Calculate(6.5, beta2, beta4, beta6, V0, R, A0, VS, A, Z, 12, loggers);
   std::vector<SingleParticleState> oddStates =
-      Calculate(6.5, beta2, beta4, beta6, V0, R, A0, VS, A, Z, 13);
+      Calculate(6.5, beta2, beta4, beta6, V0, R, A0, VS, A, Z, 13, loggers);
 
   // Join all states
   std::vector<SingleParticleState> allStates;
@@ -785,18 +803,21 @@ inline std::vector<SingleParticleState> GetAllSingleParticleStates(
  * @param dJreq double of the required spin
  * @param threshold maximum energy difference between the calculated state with
  *     the correct spin and that proposed as the one at the Fermi surface
+ * @param loggers the loggers of the transition
  * @returns SingleParticleState object. If the correct state is not found, it
  *returns
  *     the first SingleParticleState
+ * @throws std::runtime_error if the state at the Fermi surface is not bound
  */
 inline SingleParticleState CalculateDeformedSPState(int Z, int N, int A, int dJ,
                                                     double R, double beta2,
                                                     double beta4, double beta6,
                                                     double V0, double A0,
                                                     double VS, int dJreq,
-                                                    double threshold) {
+                                                    double threshold,
+                                                    const Loggers& loggers) {
   std::vector<SingleParticleState> allStates = GetAllSingleParticleStates(
-      Z, N, A, dJ, R, beta2, beta4, beta6, V0, A0, VS);
+      Z, N, A, dJ, R, beta2, beta4, beta6, V0, A0, VS, loggers);
 
   int index = 0;
   if (beta2 == 0 && beta4 == 0 && beta6 == 0) {
@@ -809,9 +830,9 @@ inline SingleParticleState CalculateDeformedSPState(int Z, int N, int A, int dJ,
     }
   } else {
     index = (Z + N - 1) / 2;
-    if (threshold > 0) {
+    if (threshold > 0 && index < allStates.size()) {
       double refEnergy = allStates[index].energy;
-      spdlog::get("nme_results_file")->info("Estimated reference state: {}/2 ({} MeV)", allStates[index].parity * allStates[index].dO,
+      loggers.nmeResults->info("Estimated reference state: {}/2 ({} MeV)", allStates[index].parity * allStates[index].dO,
       allStates[index].energy);
       index = 0;
       for (int i = 0; i < allStates.size(); i++) {
@@ -825,12 +846,18 @@ inline SingleParticleState CalculateDeformedSPState(int Z, int N, int A, int dJ,
       }
       if (index == 0) {
         index = (Z + N - 1) / 2;
-        spdlog::get("console")->warn(
+        loggers.console->warn(
             "WARNING: Couldn't find a correct spin state within the threshold.");
       }
     }
   }
-  auto nmeResults = spdlog::get("nme_results_file");
+  if (index >= allStates.size()) {
+    throw std::runtime_error(
+        "No single particle state at the Fermi surface for Z = " +
+        std::to_string(Z) + ", N = " + std::to_string(N) + ": only " +
+        std::to_string(allStates.size()) + " bound states were found");
+  }
+  const std::shared_ptr<spdlog::logger>& nmeResults = loggers.nmeResults;
   nmeResults->info("Sorted single particle states\n{:->30}", "");
 
   for (int i = 0; i < allStates.size(); i++) {
@@ -1,6 +1,7 @@
 #ifndef NUCLEAR_STRUCTURE_MANAGER
 #define NUCLEAR_STRUCTURE_MANAGER
 
+#include <iostream>
 #include <string>
 #include <vector>
 #include <map>
@@ -8,6 +9,8 @@
 #include "NuclearUtilities.h"
 #include "spdlog/spdlog.h"
 
+#include <boost/program_options/variables_map.hpp>
+
 namespace nme {
 
 namespace NuclearStructure {
@@ -19,9 +22,30 @@ namespace NuclearStructure {
 class NuclearStructureManager {
  public:
   /**
-   * Constructor
+   * Constructor using the options of the NMEOptionContainer
    */
   NuclearStructureManager();
+  /**
+   * Constructor using a given set of options, so that several transitions
+   * can be handled independently
+   *
+   * @param options the NME options of the transition
+   */
+  NuclearStructureManager(const boost::program_options::variables_map& options);
+  /**
+   * Constructor using a given set of options and the loggers of the caller,
+   * so that several transitions can be calculated at the same time without
+   * looking up loggers by name
+   *
+   * @param options the NME options of the transition
+   * @param consoleLogger logger for warnings and errors
+   * @param debugFileLogger logger for debugging output
+   * @param nmeResultsLogger logger for the results of the calculation
+   */
+  NuclearStructureManager(const boost::program_options::variables_map& options,
+                          std::shared_ptr<spdlog::logger> consoleLogger,
+                          std::shared_ptr<spdlog::logger> debugFileLogger,
+                          std::shared_ptr<spdlog::logger> nmeResultsLogger);
   /**
    * Overloaded constructor
    *
@@ -121,6 +145,8 @@ class NuclearStructureManager {
 
   std::string outputName;
 
+  boost::program_options::variables_map options; /**< the NME options of this transition */
+
   std::shared_ptr<spdlog::logger> consoleLogger;
   std::shared_ptr<spdlog::logger> debugFileLogger;
   std::shared_ptr<spdlog::logger> nmeResultsLogger;
@@ -130,6 +156,28 @@ class NuclearStructureManager {
   void InitializeLoggers();
   void InitializeConstants();
 
+  /**
+   * Get an option of this transition
+   *
+   * @template T variable type
+   * @param name variable name
+   */
+  template <typename T>
+  T GetOption(std::string name) const {
+    try {
+      return options[name].as<T>();
+    } catch (boost::bad_any_cast& e) {
+      std::cerr << "NME ERROR: Option \"" << name << "\" not defined. " << std::endl;
+      throw e;
+    }
+  }
+  /**
+   * Check whether an option of this transition was given
+   *
+   * @param name variable name
+   */
+  inline bool OptionExists(std::string name) const { return (bool)options.count(name); };
+
   void GetESPOrbitalNumbers(int&, int&, int&, int&, int&, int&);
   double GetESPManyParticleCoupling(int, ReducedOneBodyTransitionDensity&);
   bool BuildDensityMatrixFromFile(std::string);
@@ -0,0 +1,436 @@
+#include <Python.h>
+
+#define NPY_NO_DEPRECATED_API NPY_1_7_API_VERSION
+#include <numpy/arrayobject.h>
+
+#include <cmath>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "BSGOptionContainer.h"
+#include "Constants.h"
+#include "Generator.h"
+#include "GeneratorConfig.h"
+#include "NuclearStructureManager.h"
+
+/**
+ * Python extension module giving direct access to the Generator, so that
+ * scripts and the GUI do not need to start bsg_exec and parse its output.
+ *
+ *   import bsg
+ *   gen = bsg.Generator(input="63Ni.ini", options={"Spectrum.WeakMagnetism": 5})
+ *   W, electron, neutrino = gen.calculate_spectrum()
+ *
+ * The arrays returned by calculate_spectrum share the buffers of the
+ * calculated spectrum instead of copying them. The GIL is released while
+ * a Generator is constructed or calculates, so that other Python threads,
+ * such as the event loop of a GUI, keep running. Re-initializing a Generator
+ * while another thread calculates with it raises a RuntimeError.
+ */
+
+#if PY_MAJOR_VERSION >= 3
+#define BSG_PY_TEXT_CHECK PyUnicode_Check
+#define BSG_PY_TEXT_AS_STRING PyUnicode_AsUTF8
+#else
+#define BSG_PY_TEXT_CHECK PyString_Check
+#define BSG_PY_TEXT_AS_STRING PyString_AsString
+#endif
+
+/**
+ * Serializes the construction of Generators, which may fit the charge
+ * distribution with ROOT and run the nuclear structure calculation
+ */
+static std::mutex initMutex;
+
+/**
+ * Convert an option value to the text it would have in an input file
+ */
+static bool ToOptionText(PyObject* value, std::string& text) {
+  if (PyBool_Check(value)) {
+    text = value == Py_True ? "true" : "false";
+    return true;
+  }
+  PyObject* str = PyObject_Str(value);
+  if (!str) return false;
+  const char* c = BSG_PY_TEXT_AS_STRING(str);
+  if (c) text = c;
+  Py_DECREF(str);
+  return c != NULL;
+}
+
+/**
+ * Build the options of a transition from the option containers, an input and
+ * configuration file and a dict of single options, where list or tuple values
+ * give multiple values of an option
+ */
+static bool BuildConfig(PyObject* input, PyObject* config, PyObject* options, bsg::GeneratorConfig& result) {
+  result = bsg::GeneratorConfig::FromOptions();
+  if (input && input != Py_None) {
+    std::string name;
+    if (!ToOptionText(input, name)) return false;
+    if (!result.ReadInput(name)) {
+      PyErr_Format(PyExc_IOError, "Input file %s cannot be found", name.c_str());
+      return false;
+    }
+  }
+  if (config && config != Py_None) {
+    std::string name;
+    if (!ToOptionText(config, name)) return false;
+    if (!result.ReadConfig(name)) {
+      PyErr_Format(PyExc_IOError, "Configuration file %s cannot be found", name.c_str());
+      return false;
+    }
+  }
+  if (!options || options == Py_None) return true;
+  if (!PyDict_Check(options)) {
+    PyErr_SetString(PyExc_TypeError, "options must be a dict");
+    return false;
+  }
+  PyObject *key, *value;
+  Py_ssize_t position = 0;
+  while (PyDict_Next(options, &position, &key, &value)) {
+    std::string name;
+    if (!BSG_PY_TEXT_CHECK(key) || !ToOptionText(key, name)) {
+      PyErr_SetString(PyExc_TypeError, "option names must be strings");
+      return false;
+    }
+    std::vector<std::string> values;
+    if (PyList_Check(value) || PyTuple_Check(value)) {
+      PyObject* sequence = PySequence_Fast(value, "");
+      for (Py_ssize_t i = 0; i < PySequence_Fast_GET_SIZE(sequence); i++) {
+        std::string text;
+        if (!ToOptionText(PySequence_Fast_GET_ITEM(sequence, i), text)) {
+          Py_DECREF(sequence);
+          return false;
+        }
+        values.push_back(text);
+      }
+      Py_DECREF(sequence);
+    } else {
+      std::string text;
+      if (!ToOptionText(value, text)) return false;
+      values.push_back(text);
+    }
+    if (!result.Override(name, values)) {
+      PyErr_Format(PyExc_ValueError, "Unknown option or invalid value for %s", name.c_str());
+      return false;
+    }
+  }
+  return true;
+}
+
+/**
+ * Wrap a column of a spectrum owned by a capsule in an array without copying
+ */
+static PyObject* WrapColumn(const double* data, std::size_t size, PyObject* owner) {
+  npy_intp dims[1] = {(npy_intp)size};
+  PyObject* array = PyArray_SimpleNewFromData(1, dims, NPY_DOUBLE, const_cast<double*>(data));
+  if (!array) return NULL;
+  Py_INCREF(owner);
+  if (PyArray_SetBaseObject((PyArrayObject*)array, owner) != 0) {
+    Py_DECREF(array);
+    return NULL;
+  }
+  return array;
+}
+
+static void DeleteSpectrum(PyObject* capsule) {
+  delete static_cast<bsg::Spectrum*>(PyCapsule_GetPointer(capsule, "bsg.Spectrum"));
+}
+
+typedef struct {
+  PyObject_HEAD
+  bsg::Generator* gen;
+  double halflife; /**< the partial halflife, or 1 if not given */
+  double logFt; /**< log f(t) of the last calculated spectrum */
+  double meanEnergy; /**< mean kinetic energy in keV of the last calculated spectrum */
+  bool calculated; /**< whether a spectrum was calculated */
+  int busy; /**< number of calls using the Generator without holding the GIL */
+} GeneratorObject;
+
+/**
+ * Marks a Generator as in use by a call which releases the GIL, so that a
+ * concurrent re-initialization does not delete it. Only constructed and
+ * destroyed while holding the GIL, which protects the count.
+ */
+class BusyGuard {
+ public:
+  BusyGuard(GeneratorObject* self) : self(self) { self->busy++; };
+  ~BusyGuard() { self->busy--; };
+
+ private:
+  GeneratorObject* self;
+};
+
+/**
+ * Refuse to replace a Generator which is used by another thread
+ */
+static bool CheckNotBusy(GeneratorObject* self) {
+  if (self->busy > 0) {
+    PyErr_SetString(PyExc_RuntimeError, "Generator cannot be re-initialized while it is calculating");
+  }
+  return self->busy == 0;
+}
+
+static void Generator_dealloc(GeneratorObject* self) {
+  delete self->gen;
+  Py_TYPE(self)->tp_free((PyObject*)self);
+}
+
+static int Generator_init(GeneratorObject* self, PyObject* args, PyObject* kwargs) {
+  static const char* keywords[] = {"input", "config", "options", NULL};
+  PyObject *input = NULL, *config = NULL, *options = NULL;
+  if (!PyArg_ParseTupleAndKeywords(args, kwargs, "|OOO", const_cast<char**>(keywords), &input, &config, &options)) {
+    return -1;
+  }
+  if (!CheckNotBusy(self)) return -1;
+  bsg::GeneratorConfig generatorConfig;
+  if (!BuildConfig(input, config, options, generatorConfig)) return -1;
+
+  bsg::Generator* gen = NULL;
+  std::string error;
+  Py_BEGIN_ALLOW_THREADS
+  try {
+    std::lock_guard<std::mutex> lock(initMutex);
+    gen = new bsg::Generator(generatorConfig);
+  } catch (std::exception& e) {
+    error = e.what();
+  }
+  Py_END_ALLOW_THREADS
+  if (!gen) {
+    PyErr_SetString(PyExc_RuntimeError, error.c_str());
+    return -1;
+  }
+  // another thread may have started to use the old Generator meanwhile
+  if (!CheckNotBusy(self)) {
+    delete gen;
+    return -1;
+  }
+  delete self->gen;
+  self->gen = gen;
+  self->halflife = generatorConfig.Exists("Transition.PartialHalflife")
+                       ? generatorConfig.Get<double>("Transition.PartialHalflife") : 1.;
+  self->calculated = false;
+  return 0;
+}
+
+static bool CheckGenerator(GeneratorObject* self) {
+  if (!self->gen) PyErr_SetString(PyExc_RuntimeError, "Generator was not initialized");
+  return self->gen != NULL;
+}
+
+static PyObject* Generator_calculate_spectrum(GeneratorObject* self, PyObject*) {
+  if (!CheckGenerator(self)) return NULL;
+  bsg::Spectrum* spectrum = NULL;
+  std::string error;
+  BusyGuard guard(self);
+  Py_BEGIN_ALLOW_THREADS
+  try {
+    self->gen->CalculateSpectrum();
+    self->logFt = self->gen->CalculateLogFtValue(self->halflife);
+    self->meanEnergy = (self->gen->CalculateMeanEnergy() - 1.) * bsg::ELECTRON_MASS_KEV;
+    spectrum = new bsg::Spectrum(self->gen->ReleaseSpectrum());
+  } catch (std::exception& e) {
+    error = e.what();
+  }
+  Py_END_ALLOW_THREADS
+  if (!spectrum) {
+    PyErr_SetString(PyExc_RuntimeError, error.c_str());
+    return NULL;
+  }
+  self->calculated = true;
+
+  // The arrays keep the capsule, and with it the spectrum, alive
+  PyObject* capsule = PyCapsule_New(spectrum, "bsg.Spectrum", DeleteSpectrum);
+  if (!capsule) {
+    delete spectrum;
+    return NULL;
+  }
+  std::size_t n = spectrum->GetSize();
+  PyObject* W = WrapColumn(spectrum->GetW().data(), n, capsule);
+  PyObject* electron = W ? WrapColumn(spectrum->GetElectron().data(), n, capsule) : NULL;
+  PyObject* neutrino = electron ? WrapColumn(spectrum->GetNeutrino().data(), n, capsule) : NULL;
+  Py_DECREF(capsule);
+  if (!neutrino) {
+    Py_XDECREF(W);
+    Py_XDECREF(electron);
+    return NULL;
+  }
+  return Py_BuildValue("(NNN)", W, electron, neutrino);
+}
+
+static PyObject* Generator_evaluate(GeneratorObject* self, PyObject* args) {
+  PyObject* object;
+  if (!CheckGenerator(self) || !PyArg_ParseTuple(args, "O", &object)) return NULL;
+  PyArrayObject* W = (PyArrayObject*)PyArray_FROMANY(object, NPY_DOUBLE, 1, 1, NPY_ARRAY_IN_ARRAY);
+  if (!W) return NULL;
+  npy_intp dims[1] = {PyArray_SIZE(W)};
+  PyObject* electron = PyArray_SimpleNew(1, dims, NPY_DOUBLE);
+  PyObject* neutrino = PyArray_SimpleNew(1, dims, NPY_DOUBLE);
+  if (!electron || !neutrino) {
+    Py_DECREF(W);
+    Py_XDECREF(electron);
+    Py_XDECREF(neutrino);
+    return NULL;
+  }
+  std::size_t n = dims[0];
+  bsg::Span<const double> in((const double*)PyArray_DATA(W), n);
+  bsg::Span<double> outElectron((double*)PyArray_DATA((PyArrayObject*)electron), n);
+  bsg::Span<double> outNeutrino((double*)PyArray_DATA((PyArrayObject*)neutrino), n);
+  std::string error;
+  BusyGuard guard(self);
+  Py_BEGIN_ALLOW_THREADS
+  try {
+    self->gen->Evaluate(in, outElectron, outNeutrino);
+  } catch (std::exception& e) {
+    error = e.what();
+  }
+  Py_END_ALLOW_THREADS
+  Py_DECREF(W);
+  if (!error.empty()) {
+    Py_DECREF(electron);
+    Py_DECREF(neutrino);
+    PyErr_SetString(PyExc_RuntimeError, error.c_str());
+    return NULL;
+  }
+  return Py_BuildValue("(NN)", electron, neutrino);
+}
+
+static PyObject* Generator_log_ft(GeneratorObject* self, PyObject*) {
+  if (!CheckGenerator(self)) return NULL;
+  if (!self->calculated) {
+    PyErr_SetString(PyExc_RuntimeError, "Calculate the spectrum first");
+    return NULL;
+  }
+  return PyFloat_FromDouble(self->logFt);
+}
+
+static PyObject* Generator_mean_energy(GeneratorObject* self, PyObject*) {
+  if (!CheckGenerator(self)) return NULL;
+  if (!self->calculated) {
+    PyErr_SetString(PyExc_RuntimeError, "Calculate the spectrum first");
+    return NULL;
+  }
+  return PyFloat_FromDouble(self->meanEnergy);
+}
+
+/**
+ * Call a function of the Generator which may perform the nuclear structure
+ * calculation, without holding the GIL
+ */
+template <typename F>
+static PyObject* CalculateValue(GeneratorObject* self, F f) {
+  if (!CheckGenerator(self)) return NULL;
+  double value = 0.;
+  std::string error;
+  BusyGuard guard(self);
+  Py_BEGIN_ALLOW_THREADS
+  try {
+    value = f(self->gen);
+  } catch (std::exception& e) {
+    error = e.what();
+  }
+  Py_END_ALLOW_THREADS
+  if (!error.empty()) {
+    PyErr_SetString(PyExc_RuntimeError, error.c_str());
+    return NULL;
+  }
+  return PyFloat_FromDouble(value);
+}
+
+/**
+ * The nuclear structure calculation writes to the files of its own Generator,
+ * but is run for one Generator at a time like their construction
+ */
+static PyObject* Generator_weak_magnetism(GeneratorObject* self, PyObject*) {
+  return CalculateValue(self, [](bsg::Generator* gen) {
+    std::lock_guard<std::mutex> lock(initMutex);
+    return gen->GetWeakMagnetism();
+  });
+}
+
+static PyObject* Generator_induced_tensor(GeneratorObject* self, PyObject*) {
+  return CalculateValue(self, [](bsg::Generator* gen) {
+    std::lock_guard<std::mutex> lock(initMutex);
+    return gen->GetInducedTensor();
+  });
+}
+
+static PyObject* Generator_reduced_matrix_element(GeneratorObject* self, PyObject* args) {
+  int V, K, L, s;
+  if (!PyArg_ParseTuple(args, "iiii", &V, &K, &L, &s)) return NULL;
+  return CalculateValue(self, [=](bsg::Generator* gen) {
+    std::lock_guard<std::mutex> lock(initMutex);
+    return gen->GetNuclearStructureManager()->CalculateReducedMatrixElement(V != 0, K, L, s);
+  });
+}
+
+static PyMethodDef Generator_methods[] = {
+    {"calculate_spectrum", (PyCFunction)Generator_calculate_spectrum, METH_NOARGS,
+     "Calculate the spectrum and return the arrays W, electron and neutrino, "
+     "which share the memory of the calculated spectrum."},
+    {"evaluate", (PyCFunction)Generator_evaluate, METH_VARARGS,
+     "Return the electron and neutrino decay rates at an array of total energies W."},
+    {"log_ft", (PyCFunction)Generator_log_ft, METH_NOARGS,
+     "Return log f(t) of the last calculated spectrum, using Transition.PartialHalflife if given."},
+    {"mean_energy", (PyCFunction)Generator_mean_energy, METH_NOARGS,
+     "Return the mean kinetic energy in keV of the last calculated spectrum."},
+    {"weak_magnetism", (PyCFunction)Generator_weak_magnetism, METH_NOARGS,
+     "Return b/Ac, calculating the nuclear matrix elements if needed."},
+    {"induced_tensor", (PyCFunction)Generator_induced_tensor, METH_NOARGS,
+     "Return d/Ac, calculating the nuclear matrix elements if needed."},
+    {"reduced_matrix_element", (PyCFunction)Generator_reduced_matrix_element, METH_VARARGS,
+     "reduced_matrix_element(V, K, L, s): return the reduced matrix element of the "
+     "nuclear structure calculation."},
+    {NULL, NULL, 0, NULL}};
+
+static PyTypeObject GeneratorType = {PyVarObject_HEAD_INIT(NULL, 0)};
+
+#if PY_MAJOR_VERSION >= 3
+static struct PyModuleDef bsgModule = {PyModuleDef_HEAD_INIT, "bsg", "Beta Spectrum Generator", -1, NULL};
+#define BSG_INIT_ERROR NULL
+#else
+#define BSG_INIT_ERROR
+#endif
+
+#if PY_MAJOR_VERSION >= 3
+PyMODINIT_FUNC PyInit_bsg(void) {
+#else
+PyMODINIT_FUNC initbsg(void) {
+#endif
+  import_array();
+
+  // Set up the option descriptions and the defaults of all options, without
+  // commandline arguments
+  static char name[] = "bsg";
+  static char* argv[] = {name, NULL};
+  bsg::BSGOptionContainer::GetInstance(1, argv);
+
+  GeneratorType.tp_name = "bsg.Generator";
+  GeneratorType.tp_basicsize = sizeof(GeneratorObject);
+  GeneratorType.tp_dealloc = (destructor)Generator_dealloc;
+  GeneratorType.tp_flags = Py_TPFLAGS_DEFAULT;
+  GeneratorType.tp_doc =
+      "Generator(input=None, config=None, options=None)\n\n"
+      "Beta spectrum generator for the transition of an input file, with the "
+      "options of a configuration file and a dict of single options such as "
+      "{'Spectrum.WeakMagnetism': 5}.";
+  GeneratorType.tp_methods = Generator_methods;
+  GeneratorType.tp_init = (initproc)Generator_init;
+  GeneratorType.tp_new = PyType_GenericNew;
+  if (PyType_Ready(&GeneratorType) < 0) return BSG_INIT_ERROR;
+
+#if PY_MAJOR_VERSION >= 3
+  PyObject* module = PyModule_Create(&bsgModule);
+#else
+  PyObject* module = Py_InitModule3("bsg", NULL, "Beta Spectrum Generator");
+#endif
+  if (!module) return BSG_INIT_ERROR;
+  Py_INCREF(&GeneratorType);
+  PyModule_AddObject(module, "Generator", (PyObject*)&GeneratorType);
+#if PY_MAJOR_VERSION >= 3
+  return module;
+#endif
+}